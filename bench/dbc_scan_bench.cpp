@@ -0,0 +1,81 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "../dbc/dbc_scan.h"
+
+/* Compares the vectorized column scans of dbc_scan.h with the scalar scans, on a column the size of a large dbc file */
+
+namespace
+{
+    const unsigned int rows = 100000;
+    const unsigned int repeats = 2000;
+
+    const char * simd_name(dbc_simd simd)
+    {
+        switch(simd)
+        {
+        case dbc_simd::SCALAR:  return "scalar";
+        case dbc_simd::SSE2:    return "sse2";
+        case dbc_simd::AVX2:    return "avx2";
+        }
+        return "";
+    }
+
+    /* ns per row of scanning values with op */
+    template <typename T>
+    double measure(const std::vector<T> & values, dbc_scan_op op, T a, T b, dbc_simd simd, uint64_t & checksum)
+    {
+        std::vector<uint64_t> words((values.size() + 63)/64);
+        const auto begin = std::chrono::steady_clock::now();
+        for(unsigned int i = 0; i < repeats; ++i)
+        {
+            dbc_scan(values.data(),static_cast<unsigned int>(values.size()),op,a,b,words.data(),simd);
+            checksum += words[i % words.size()];
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double,std::nano>(end - begin).count()/(double(repeats)*values.size());
+    }
+
+    template <typename T>
+    void run(const char * type, const std::vector<T> & values, const char * name, dbc_scan_op op, T a, T b)
+    {
+        uint64_t checksum = 0;
+        const double scalar = measure(values,op,a,b,dbc_simd::SCALAR,checksum);
+        std::printf("%-6s %-10s %-7s %7.3f ns/row\n",type,name,simd_name(dbc_simd::SCALAR),scalar);
+        for(dbc_simd simd : {dbc_simd::SSE2,dbc_simd::AVX2})
+        {
+            if(static_cast<int>(simd) > static_cast<int>(dbc_scan_simd()))
+                continue;
+            const double t = measure(values,op,a,b,simd,checksum);
+            std::printf("%-6s %-10s %-7s %7.3f ns/row  %5.1fx\n",type,name,simd_name(simd),t,scalar/t);
+        }
+        /* Keeps the scans from being optimized away */
+        if(checksum == 1)
+            std::printf("\n");
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(42);
+    std::vector<int> ints(rows);
+    std::vector<float> floats(rows);
+    for(unsigned int i = 0; i < rows; ++i)
+    {
+        ints[i] = static_cast<int>(rng() % 256);
+        floats[i] = static_cast<float>(rng() % 10000)/100.0f;
+    }
+
+    std::printf("%u rows, best instruction set: %s\n",rows,simd_name(dbc_scan_simd()));
+    run("int",ints,"==",dbc_scan_op::EQUAL,17,0);
+    run("int",ints,"!=",dbc_scan_op::NOT_EQUAL,17,0);
+    run("int",ints,"<",dbc_scan_op::LESS,100,0);
+    run("int",ints,"range",dbc_scan_op::IN_RANGE,50,150);
+    run("int",ints,"any bits",dbc_scan_op::ANY_BITS,0x24,0);
+    run("int",ints,"all bits",dbc_scan_op::ALL_BITS,0x24,0);
+    run("float",floats,"==",dbc_scan_op::EQUAL,17.0f,0.0f);
+    run("float",floats,"<",dbc_scan_op::LESS,50.0f,0.0f);
+    run("float",floats,"range",dbc_scan_op::IN_RANGE,25.0f,75.0f);
+    return 0;
+}
@@ -0,0 +1,16 @@
+# Microbenchmark of the column scans in dbc/dbc_scan.h, built apart from the application:
+#   qmake dbc_scan_bench.pro && make && ./dbc_scan_bench
+
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt app_bundle
+
+TARGET = dbc_scan_bench
+
+SOURCES += dbc_scan_bench.cpp \
+    ../dbc/dbc_scan.cpp
+
+HEADERS += ../dbc/dbc_scan.h
+
+QMAKE_CXXFLAGS += -std=c++14
+CONFIG += release
@@ -56,6 +56,10 @@ class configuration
         { return "MYSQL"; }
         else if (id.compare("DBC.Directory") == 0)
         { return QDir::currentPath() + QString{"/dbc/"}; }
+        else if (id.compare("DBC.Cache") == 0)
+        { return QDir::currentPath() + QString{"/cache/"}; }
+        else if (id.compare("DBC.Locale") == 0)
+        { return "enUS"; }
         else if (id.compare("Session.Directory") == 0)
         { return QDir::currentPath() + QString{"/session/"}; }
         else if (id.compare("Session.Previous") == 0)
@@ -124,6 +128,8 @@ class configuration
         m_data["DB.DBMS"] = data;
         data.type = field_type::string;
         m_data["DBC.Directory"] = data;
+        m_data["DBC.Cache"] = data;
+        m_data["DBC.Locale"] = data;
         m_data["Session.Directory"] = data;
         m_data["Session.Previous"] = data;
         m_data["Session.File.Prepend"] = data;
@@ -173,6 +179,9 @@ class configuration
         QDir dbc_dir{m_data["DBC.Directory"].value};
         if(!dbc_dir.exists())
             dbc_dir.mkpath(m_data["DBC.Directory"].value);
+        QDir cache_dir{m_data["DBC.Cache"].value};
+        if(!cache_dir.exists())
+            cache_dir.mkpath(m_data["DBC.Cache"].value);
         QDir session_dir{m_data["Session.Directory"].value};
         if(!session_dir.exists())
             session_dir.mkpath(m_data["Session.Directory"].value);
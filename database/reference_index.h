@@ -0,0 +1,321 @@
+#ifndef REFERENCE_INDEX_H
+#define REFERENCE_INDEX_H
+
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <initializer_list>
+#include <algorithm>
+#include "table.h"
+#include "creature_template.h"
+#include "../dbc/dbc_files.h"
+
+/*
+ *  Reverse references: who uses a DBC row
+ *
+ *  Records of database tables refer to DBC records by foreign keys, fields holding the key of a DBC record (the
+ *  family of a creature, its factions). A reference index has, for every referred key, the keys of the records
+ *  referring to it, so editing a DBC record can tell which records it affects without scanning the tables.
+ *
+ *  The references are stored like a compressed sparse row matrix: the referred keys in order, and for each one a range
+ *  in one array of the referrers. The index is built by scanning the foreign key fields of a table once. Edits of the
+ *  table are then kept aside, as added and removed references, until there are enough of them to rebuild the arrays.
+ *
+ *  A foreign key field of 0 refers to no record and is not indexed.
+ *
+ *  Records of DBC tables refer to records of other DBC tables the same way. Their references are indexed from the rows
+ *  of a join of the tables (see dbc_join.h), by row, and never change.
+ */
+
+namespace dbutil
+{
+
+template <typename KEY>
+class reference_index
+{
+private:
+    std::vector<int>                    m_referred;     /* The referred keys, ascending */
+    std::vector<unsigned int>           m_offsets;      /* The referrers of m_referred[i] are from m_offsets[i] to m_offsets[i+1] */
+    std::vector<KEY>                    m_referrers;    /* Ascending for each referred key */
+    /* The edits since the arrays were built */
+    std::map<int,std::vector<KEY>>      m_added;
+    std::set<std::pair<int,KEY>>        m_removed;
+    unsigned int                        m_added_count;
+
+    /* The range of the referrers of referred in m_referrers */
+    std::pair<unsigned int,unsigned int> range_of(int referred) const
+    {
+        auto it = std::lower_bound(m_referred.begin(),m_referred.end(),referred);
+        if(it == m_referred.end() || *it != referred)
+            return std::pair<unsigned int,unsigned int>{0,0};
+        const size_t i = static_cast<size_t>(it - m_referred.begin());
+        return std::pair<unsigned int,unsigned int>{m_offsets[i],m_offsets[i+1]};
+    }
+
+    bool in_arrays(int referred, const KEY & referrer) const
+    {
+        const std::pair<unsigned int,unsigned int> r = range_of(referred);
+        return std::binary_search(m_referrers.begin() + r.first,m_referrers.begin() + r.second,referrer);
+    }
+
+    /* Rebuild the arrays once the edits kept aside cost more to look through than a rebuild */
+    void compact_if_needed()
+    {
+        const size_t edits = m_added_count + m_removed.size();
+        if(edits < 1024 || edits*16 < m_referrers.size())
+            return;
+        std::vector<std::pair<int,KEY>> references;
+        references.reserve(m_referrers.size() + m_added_count);
+        for(size_t i = 0; i < m_referred.size(); ++i)
+        {
+            for(unsigned int j = m_offsets[i]; j < m_offsets[i+1]; ++j)
+            {
+                const std::pair<int,KEY> r{m_referred[i],m_referrers[j]};
+                if(!m_removed.count(r))
+                    references.push_back(r);
+            }
+        }
+        for(const auto & a : m_added)
+        {
+            for(const KEY & referrer : a.second)
+                references.push_back(std::pair<int,KEY>{a.first,referrer});
+        }
+        build(std::move(references));
+    }
+
+public:
+    reference_index() : m_referred(), m_offsets(1,0), m_referrers(), m_added(), m_removed(), m_added_count(0) {}
+
+    /* Build from pairs of referred key and referrer */
+    void build(std::vector<std::pair<int,KEY>> references)
+    {
+        std::sort(references.begin(),references.end());
+        references.erase(std::unique(references.begin(),references.end()),references.end());
+        m_referred.clear();
+        m_offsets.assign(1,0);
+        m_referrers.clear();
+        m_referrers.reserve(references.size());
+        for(const std::pair<int,KEY> & r : references)
+        {
+            if(m_referred.empty() || m_referred.back() != r.first)
+            {
+                m_referred.push_back(r.first);
+                m_offsets.push_back(m_offsets.back());
+            }
+            m_referrers.push_back(r.second);
+            ++m_offsets.back();
+        }
+        m_added.clear();
+        m_removed.clear();
+        m_added_count = 0;
+    }
+
+    /* referrer now refers to referred. It must not already. */
+    void add(int referred, const KEY & referrer)
+    {
+        auto it = m_removed.find(std::pair<int,KEY>{referred,referrer});
+        if(it != m_removed.end())
+            m_removed.erase(it);
+        else
+        {
+            m_added[referred].push_back(referrer);
+            ++m_added_count;
+        }
+        compact_if_needed();
+    }
+    /* referrer no longer refers to referred */
+    void remove(int referred, const KEY & referrer)
+    {
+        auto it = m_added.find(referred);
+        if(it != m_added.end())
+        {
+            auto r = std::find(it->second.begin(),it->second.end(),referrer);
+            if(r != it->second.end())
+            {
+                it->second.erase(r);
+                if(it->second.empty())
+                    m_added.erase(it);
+                --m_added_count;
+                return;
+            }
+        }
+        if(in_arrays(referred,referrer))
+        {
+            m_removed.insert(std::pair<int,KEY>{referred,referrer});
+            compact_if_needed();
+        }
+    }
+
+    /* Call f(referrer) for every referrer of referred */
+    template <typename F>
+    void for_each_referrer(int referred, F f) const
+    {
+        const std::pair<unsigned int,unsigned int> r = range_of(referred);
+        for(unsigned int i = r.first; i < r.second; ++i)
+        {
+            if(m_removed.empty() || !m_removed.count(std::pair<int,KEY>{referred,m_referrers[i]}))
+                f(m_referrers[i]);
+        }
+        auto it = m_added.find(referred);
+        if(it != m_added.end())
+        {
+            for(const KEY & referrer : it->second)
+                f(referrer);
+        }
+    }
+
+    std::vector<KEY> referrers(int referred) const
+    {
+        std::vector<KEY> keys;
+        for_each_referrer(referred,[&keys](const KEY & k){ keys.push_back(k); });
+        return keys;
+    }
+    unsigned int count(int referred) const
+    {
+        unsigned int n = 0;
+        for_each_referrer(referred,[&n](const KEY &){ ++n; });
+        return n;
+    }
+};
+
+/* The fields FIELDS of the records of table T hold keys of records of the DBC file REFERRED */
+template <typename T, dbc_file_type REFERRED, typename T::field_index ... FIELDS>
+struct foreign_key
+{
+    typedef T table_type;
+    static constexpr const dbc_file_type referred = REFERRED;
+};
+
+typedef foreign_key<creature_template_tbc,dbc_file_type::CreatureFamily,
+                    creature_template_tbc::field_index::Family> creature_template_family_key;
+typedef foreign_key<creature_template_tbc,dbc_file_type::CreatureType,
+                    creature_template_tbc::field_index::CreatureType> creature_template_type_key;
+typedef foreign_key<creature_template_tbc,dbc_file_type::FactionTemplate,
+                    creature_template_tbc::field_index::FactionAlliance,
+                    creature_template_tbc::field_index::FactionHorde> creature_template_faction_key;
+typedef foreign_key<creature_template_tbc,dbc_file_type::CreatureDisplayInfo,
+                    creature_template_tbc::field_index::ModelId1,creature_template_tbc::field_index::ModelId2,
+                    creature_template_tbc::field_index::ModelId3,creature_template_tbc::field_index::ModelId4> creature_template_model_key;
+
+namespace detail
+{
+    template <typename TV>
+    struct single_key_field;
+    template <size_t V>
+    struct single_key_field<dbtmp::tuple_v<V>>
+    {
+        enum { value = V };
+    };
+} // namespace detail
+
+/* The references of a table by one foreign key */
+template <typename FOREIGN_KEY>
+class table_references;
+
+template <typename T, dbc_file_type REFERRED, typename T::field_index ... FIELDS>
+class table_references<foreign_key<T,REFERRED,FIELDS...>>
+{
+private:
+    enum { key_field = detail::single_key_field<typename T::primary_key_fields>::value };
+public:
+    /* The primary key of the referring records */
+    typedef dbtmp::get_type_at_tuple<key_field,typename T::field_types> key_type;
+
+private:
+    reference_index<key_type> m_index;
+
+    /* The distinct non-zero values of the foreign key fields */
+    static std::vector<int> referred_keys(std::initializer_list<int> values)
+    {
+        std::vector<int> keys;
+        for(int v : values)
+        {
+            if(v != 0 && std::find(keys.begin(),keys.end(),v) == keys.end())
+                keys.push_back(v);
+        }
+        return keys;
+    }
+
+public:
+    /* Scan the foreign key fields of every record of the table in the database once */
+    template <typename I>
+    bool load(I & i)
+    {
+        /* SELECT key,f1,f2... FROM table_name; */
+        std::string query = "SELECT ";
+        query.append(T::field_name[key_field].get_data());
+        for(const char * name : {T::field_name[static_cast<size_t>(FIELDS)].get_data()...})
+        {
+            query.push_back(',');
+            query.append(name);
+        }
+        query.append(" FROM ");
+        query.append(T::table_name.get_data());
+        query.push_back(';');
+        i.query(query.c_str());
+        if(!i.no_error_occured())
+            return false;
+        std::vector<std::pair<int,key_type>> references;
+        while(i.next())
+        {
+            const key_type key = detail::get_field_from_query_helper<key_type>::template get<0>(i);
+            int column = 1;
+            for(int referred : referred_keys({(static_cast<void>(FIELDS),i.get_data_at(column++))...}))
+                references.push_back(std::pair<int,key_type>{referred,key});
+        }
+        m_index.build(std::move(references));
+        return true;
+    }
+
+    /* Keep the index up to date with the edits recorded by t */
+    void follow(table<T> & t)
+    {
+        t.add_edit_listener([this](const auto & record, bool added)
+        {
+            const key_type key = *dbtmp::get<key_field>(record).get_data();
+            for(int referred : referred_keys({*dbtmp::get<static_cast<size_t>(FIELDS)>(record).get_data()...}))
+            {
+                if(added)
+                    m_index.add(referred,key);
+                else
+                    m_index.remove(referred,key);
+            }
+        });
+    }
+
+    /* The keys of the records referring to the DBC record of key referred */
+    std::vector<key_type> referrers(int referred) const { return m_index.referrers(referred); }
+    unsigned int count(int referred) const { return m_index.count(referred); }
+    const reference_index<key_type> & index() const { return m_index; }
+};
+
+/* The references of the records of a DBC table to the records of another, by a join of the tables (see dbc_join.h) */
+template <typename JOIN>
+class dbc_references
+{
+private:
+    reference_index<unsigned int> m_index;
+
+public:
+    /* Index the rows of join, which must be built */
+    void load(const JOIN & join)
+    {
+        std::vector<std::pair<int,unsigned int>> references;
+        join.for_each_reference([&references](unsigned int referred, unsigned int referrer)
+        {
+            references.push_back(std::pair<int,unsigned int>{static_cast<int>(referred),referrer});
+        });
+        m_index.build(std::move(references));
+    }
+
+    /* The rows of the referring table whose records refer to the record at row of the referred table, whose row of a
+     * key is dbc_table::row_of_key */
+    std::vector<unsigned int> referrers(unsigned int row) const { return m_index.referrers(static_cast<int>(row)); }
+    unsigned int count(unsigned int row) const { return m_index.count(static_cast<int>(row)); }
+};
+
+} // namespace dbutil
+
+#endif // REFERENCE_INDEX_H
@@ -7,6 +7,7 @@
 #include <string.h>
 #include <cstring>
 #include <array>
+#include <functional>
 #include "dbtmp.h"
 #include <iostream>
 
@@ -411,6 +412,15 @@ private:
     std::map<key_type, table_record> insertions;
     std::map<key_type, table_record> deletions;
 
+    /* Told about every record an edit removed from or added to the database, see add_edit_listener() */
+    std::vector<std::function<void(const table_record &, bool)>> edit_listeners;
+
+    void notify(const table_record & r, bool added) const
+    {
+        for(const auto & l : edit_listeners)
+            l(r,added);
+    }
+
     template <typename ... FS>
     struct fields
     {
@@ -814,6 +824,14 @@ private:
 
 public:
 
+    /* listener(record,added) is called with every record an edit removes from the database (added is false) or adds
+     * to it (added is true), once the database has done so. Replacing a record removes the old one and adds the new. */
+    typedef std::function<void(const table_record &, bool)> edit_listener;
+    void add_edit_listener(edit_listener listener)
+    {
+        edit_listeners.push_back(std::move(listener));
+    }
+
     template <typename I, typename ... FS>
     std::string insert_entry(I & i, FS ... fs)
     {
@@ -842,6 +860,7 @@ public:
                 if(i.no_error_occured())
                 {
                     //qDebug("... so we delete the newest entry from the database.\n");
+                    notify((*iti).second,false);
                     insertions.erase(iti);
                 }
                 else
@@ -856,6 +875,7 @@ public:
                 if(i.no_error_occured())
                 {
                     //qDebug("... and we can now delete the recordings of what was deleted.\n");
+                    notify(new_record,true);
                     deletions.erase(itd);
                 }
                 else
@@ -871,6 +891,7 @@ public:
                 if(i.no_error_occured())
                 {
                     //qDebug("... so we record what that data is.\n");
+                    notify(new_record,true);
                     insertions.insert(std::pair<key_type,table_record>{primary_key,new_record});
                 }
                 else
@@ -900,6 +921,8 @@ public:
                 deletions.insert(std::pair<key_type,table_record>{primary_key,old_record});
                 /* Then delete it */
                 record_helper<primary_key_fields>::delete_from(*this,i,primary_key);
+                if(i.no_error_occured())
+                    notify(old_record,false);
             }
             if((!found) || (found && i.no_error_occured()))
             {
@@ -908,6 +931,7 @@ public:
                 record_helper<TBLSEQ>::insert_into(*this,i,new_record);
                 if(i.no_error_occured())
                 {
+                    notify(new_record,true);
                     insertions.insert(std::pair<key_type,table_record>{primary_key,new_record});
                 }
                 else
@@ -933,11 +957,13 @@ public:
             record_helper<primary_key_fields>::delete_from(*this,i,primary_key);
             if(i.no_error_occured())
             {
+                notify((*iti).second,false);
                 insertions.erase(primary_key);
                 record_helper<TBLSEQ>::insert_into(*this,i,new_record);
                 if(i.no_error_occured())
                 {
                     //qDebug("... and now we can safely insert the new entry.\n");
+                    notify(new_record,true);
                     insertions.insert(std::pair<key_type,table_record>{primary_key,new_record});
                 }
                 else
@@ -971,6 +997,7 @@ public:
                 record_helper<primary_key_fields>::delete_from(*this,i,primary_key);
                 if(i.no_error_occured())
                 {
+                    notify((*iti).second,false);
                     insertions.erase(iti);
                 }
                 else
@@ -991,6 +1018,8 @@ public:
                 deletions.insert(std::pair<key_type,table_record>{primary_key,old_record});
                 /* Then delete it */
                 record_helper<primary_key_fields>::delete_from(*this,i,primary_key);
+                if(i.no_error_occured())
+                    notify(old_record,false);
             }
         }
         /* It does not exist in deletions but exists in insertions */
@@ -999,6 +1028,7 @@ public:
             record_helper<primary_key_fields>::delete_from(*this,i,primary_key);
             if(i.no_error_occured())
             {
+                notify((*iti).second,false);
                 insertions.erase(primary_key);
             }
             else
@@ -2,8 +2,23 @@
 #define DBC_H
 
 #include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <QFileInfo>
+#include <QDateTime>
 
 #include "../directory.h"
+#include "dbc_hash.h"
+#include "dbc_strings.h"
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #include "dbc_record.h"
 #include "../tmp/tmp_types.h"
 
@@ -11,6 +26,7 @@ enum class dbc_state
 {
     BEGIN,
     CONFIGURED,
+    LOADING,
     LOADED
 };
 
@@ -20,7 +36,34 @@ enum class dbc_error
     FILE_NOT_FOUND
 };
 
+enum class dbc_load_mode
+{
+    READ,       /* Read the whole file into a private heap buffer */
+    MAP         /* Map the file read-only into memory, so the page cache is shared between processes.
+                 * Falls back to READ where memory mapping is not available. */
+};
+
+
 
+/* Identifies the contents of a loaded file, so derived data that was saved can be checked against it */
+struct dbc_source_signature
+{
+    uint64_t    size;
+    int64_t     modified;   /* ms since epoch */
+    uint64_t    hash;       /* dbc_impl::hash_bytes of the whole file */
+};
+
+/* The locale named name (enUS, deDE...), enUS if there is no such locale */
+inline dbc_locale dbc_locale_from_name(const QString & name)
+{
+    static const char * const names[] = { "enUS","koKR","frFR","deDE","zhCN","zhTW","esES","esMX","ruRU" };
+    for(unsigned int i = 0; i < sizeof(names)/sizeof(names[0]); ++i)
+    {
+        if(name.compare(names[i]) == 0)
+            return static_cast<dbc_locale>(i);
+    }
+    return dbc_locale::enUS;
+}
 
 struct dbc_header
 {
@@ -44,13 +87,113 @@ private:
     template <field_index I>
     using field_type = tmp::get_element_in<static_cast<size_t>(I), field_types>;
 
-    dbc_state               m_state;
-    dbc_error               m_error;
+    /* Files are read in chunks of this size, so that progress can be observed while loading */
+    static constexpr size_t chunk_size = 1 << 20;
+
+    std::atomic<dbc_state>  m_state;
+    /* Written by the loader thread, read by any */
+    std::atomic<dbc_error>  m_error;
+    dbc_load_mode           m_load_mode;
     unsigned int            m_number_of_entries;
     const dbc_directory *   m_directory;
     QString                 m_path;
 
     char       *            m_memory_block;
+    size_t                  m_memory_size;
+    bool                    m_memory_mapped;
+
+    std::atomic<size_t>     m_bytes_total;
+    std::atomic<size_t>     m_bytes_loaded;
+    std::thread             m_loader;
+    dbc_source_signature    m_signature;
+
+    /* One copy of the string block, shared by every table built from this file. It outlives discard(). */
+    mutable std::mutex                  m_strings_mutex;
+    mutable std::shared_ptr<const char> m_strings;
+
+    std::shared_ptr<const char> shared_string_block() const
+    {
+        std::lock_guard<std::mutex> lock(m_strings_mutex);
+        if(!m_strings)
+        {
+            const dbc_header * h = reinterpret_cast<const dbc_header*>(m_memory_block);
+            m_strings = dbc_impl::make_string_block(m_memory_block + sizeof(dbc_header) + h->record_count*record_type::size,
+                                                    h->string_block_size);
+        }
+        return m_strings;
+    }
+
+    bool load_mapped()
+    {
+#ifdef Q_OS_UNIX
+        int fd = ::open(m_path.toStdString().c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+        struct stat st;
+        if(::fstat(fd,&st) != 0 || st.st_size < static_cast<off_t>(sizeof(dbc_header)))
+        {
+            ::close(fd);
+            return false;
+        }
+        void * p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        /* The mapping keeps its own reference to the file */
+        ::close(fd);
+        if(p == MAP_FAILED)
+            return false;
+        m_memory_block = static_cast<char*>(p);
+        m_memory_size = static_cast<size_t>(st.st_size);
+        m_memory_mapped = true;
+        m_bytes_total = m_memory_size;
+
+        /* Hashing faults the pages in chunk by chunk, so the load is done when we say it is and progress can be observed */
+        ::madvise(p, m_memory_size, MADV_WILLNEED);
+        for(size_t offset = 0; offset < m_memory_size; offset += chunk_size)
+        {
+            const size_t n = std::min(chunk_size, m_memory_size - offset);
+            m_signature.hash = dbc_impl::hash_bytes(m_memory_block + offset, n, m_signature.hash);
+            m_bytes_loaded = offset + n;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool load_read()
+    {
+        std::ifstream file(m_path.toStdString(), std::ios::in|std::ios::binary|std::ios::ate);
+        if(!file.is_open())
+            return false;
+        std::streampos size = file.tellg();
+        m_memory_block = new char [size];
+        m_memory_size = static_cast<size_t>(size);
+        m_memory_mapped = false;
+        m_bytes_total = m_memory_size;
+        file.seekg(0, std::ios::beg);
+        for(size_t offset = 0; offset < m_memory_size; offset += chunk_size)
+        {
+            const size_t n = std::min(chunk_size, m_memory_size - offset);
+            file.read(m_memory_block + offset, static_cast<std::streamsize>(n));
+            m_signature.hash = dbc_impl::hash_bytes(m_memory_block + offset, n, m_signature.hash);
+            m_bytes_loaded = offset + n;
+        }
+        file.close();
+        return true;
+    }
+
+    void release_memory()
+    {
+#ifdef Q_OS_UNIX
+        if(m_memory_mapped)
+        {
+            ::munmap(m_memory_block, m_memory_size);
+            m_memory_block = nullptr;
+            return;
+        }
+#endif
+        delete [] m_memory_block;
+        m_memory_block = nullptr;
+    }
 
 
     inline const char *     get_record_data(unsigned int idx) const
@@ -70,16 +213,25 @@ public:
     {
         m_state = dbc_state::BEGIN;
         m_error = dbc_error::NO_ERROR;
+        m_load_mode = dbc_load_mode::READ;
+        m_memory_block = nullptr;
+        m_memory_size = 0;
+        m_memory_mapped = false;
+        m_bytes_total = 0;
+        m_bytes_loaded = 0;
+        m_signature = dbc_source_signature{0,0,0};
     }
     ~dbc_file()
     {
+        wait();
         if(m_state == dbc_state::LOADED)
-            delete [] m_memory_block;
+            release_memory();
     }
 
-    void configure(const dbc_directory & dir)
+    void configure(const dbc_directory & dir, dbc_load_mode mode = dbc_load_mode::READ)
     {
         m_directory = &dir;
+        m_load_mode = mode;
         m_path = dir.path() + QString{"/"} + QString{file_name.get_data()} + QString{".dbc"};
         m_state = dbc_state::CONFIGURED;
     }
@@ -100,41 +252,84 @@ public:
         }
         return std::string{""};
     }
-    /* Try to perform the load */
+    /* Try to perform the load, unless it is loaded or being loaded already */
     void        load()
     {
-        std::ifstream file(m_path.toStdString(), std::ios::in|std::ios::binary|std::ios::ate);
-        std::streampos size;
-        if(file.is_open())
+        if(!begin_load())
+            return;
+        load_impl();
+    }
+    /* Perform the load on a worker thread, progress can be observed through progress_value() meanwhile */
+    void        load_async()
+    {
+        if(m_state != dbc_state::CONFIGURED)
+            return;
+        wait();
+        if(!begin_load())
+            return;
+        m_loader = std::thread{[this](){ load_impl(); }};
+    }
+    /* Block until an asynchronous load has finished */
+    void        wait()
+    {
+        if(m_loader.joinable())
+            m_loader.join();
+    }
+
+private:
+    /* Only one load runs at a time: the caller that moves the state from CONFIGURED to LOADING */
+    bool        begin_load()
+    {
+        dbc_state configured = dbc_state::CONFIGURED;
+        return m_state.compare_exchange_strong(configured,dbc_state::LOADING);
+    }
+    void        load_impl()
+    {
+        m_bytes_total = 0;
+        m_bytes_loaded = 0;
+        m_signature.hash = dbc_impl::hash_seed;
+        bool loaded = (m_load_mode == dbc_load_mode::MAP && load_mapped()) || load_read();
+        if(loaded)
         {
-            size = file.tellg();
-            m_memory_block = new char [size];
-            file.seekg(0, std::ios::beg);
-            file.read(m_memory_block,size);
-            file.close();
-            // Load header first
-            m_state = dbc_state::LOADED;
+            m_signature.size = m_memory_size;
+            m_signature.modified = QFileInfo{m_path}.lastModified().toMSecsSinceEpoch();
             m_error = dbc_error::NO_ERROR;
+            m_state = dbc_state::LOADED;
         }
         else
         {
             m_error = dbc_error::FILE_NOT_FOUND;
+            m_state = dbc_state::CONFIGURED;
         }
     }
 
+public:
+
     /* Perform necessary work to enable a succesful load */
     bool        correct_error() const   { return m_directory->add_file(QString{file_name.get_data()}); }
     /* Progress */
-    float       progress_value() const  { return is_completed() ? 100.0f : 0.0f; }
+    float       progress_value() const
+    {
+        if(is_completed())
+            return 100.0f;
+        const size_t total = m_bytes_total;
+        return (is_loading() && total) ? 100.0f*float(m_bytes_loaded)/float(total) : 0.0f;
+    }
+    /* Is a load in progress? */
+    bool        is_loading() const      { return m_state == dbc_state::LOADING; }
     /* Is loading completed successfully? */
     bool        is_completed() const    { return m_state == dbc_state::LOADED; }
     /* Discard the data */
     void        discard()
     {
+        wait();
         if(m_state == dbc_state::LOADED)
         {
             m_state = dbc_state::CONFIGURED;
-            delete [] m_memory_block;
+            release_memory();
+            /* Tables holding the strings keep them alive */
+            std::lock_guard<std::mutex> lock(m_strings_mutex);
+            m_strings.reset();
         }
     }
 
@@ -156,6 +351,7 @@ public:
         }
 
         bool is_valid() const { return m_dbc.is_valid(); }
+        bool is_loading() const { return m_dbc.is_loading(); }
         std::string error_msg() const { return m_dbc.error_msg(); }
         bool correct_error() const { return m_dbc.correct_error(); }
         float progress_value() const { return m_dbc.progress_value(); }
@@ -168,10 +364,17 @@ public:
         {
             return (m_dbc.m_memory_block + sizeof(dbc_header)) + count()*record_type::size;
         }
+        /* The string block, copied once and shared with everyone else asking for it */
+        std::shared_ptr<const char> shared_string_block() const { return m_dbc.shared_string_block(); }
+        const char * file_name() const { return DBC_FILE::file_name.get_data(); }
+        const dbc_source_signature & source_signature() const { return m_dbc.m_signature; }
     };
 
     /* Get the data view */
     view operator()() const { return view{*this}; }
 };
 
+template <typename DBC_FILE>
+constexpr size_t dbc_file<DBC_FILE>::chunk_size;
+
 #endif // DBC_H
@@ -0,0 +1,312 @@
+#ifndef DBC_AGGREGATE_H
+#define DBC_AGGREGATE_H
+
+#include <vector>
+#include <tuple>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+#include "dbc_filter.h"
+#include "dbc_scan.h"
+#include "../resource/task_pool.h"
+
+/*
+ *  Aggregates of a column grouped by an integer column
+ *
+ *  Rows are grouped by their key, the value of an integer column such as a class or a school, and each group gets the
+ *  count, smallest, largest and sum of the values of another column. Grouping by the key alone gives the histogram of
+ *  the key.
+ *
+ *  The groups are accumulated in an array indexed by key when the keys span a small range, which the smallest and
+ *  largest key tell (a vector reduction, see dbc_scan.h), and else in a hash table. On a pool every worker accumulates
+ *  a part of the rows in its own accumulators, which are merged at the end.
+ *
+ *  The result is a read-only table of one record per group, ordered by key, which dbc_model_adaptor can show.
+ */
+
+namespace dbc_impl
+{
+    /* Integers are summed in 64 bits, they do not overflow */
+    template <typename T>
+    struct dbc_sum_type { typedef double type; };
+    template <>
+    struct dbc_sum_type<int> { typedef int64_t type; };
+
+    template <typename T>
+    struct dbc_group_partial
+    {
+        typedef typename dbc_sum_type<T>::type sum_t;
+
+        unsigned int    count;
+        T               min;
+        T               max;
+        sum_t           sum;
+
+        dbc_group_partial() : count(0), min(), max(), sum() {}
+
+        void add(T v)
+        {
+            if(count == 0 || v < min)
+                min = v;
+            if(count == 0 || v > max)
+                max = v;
+            sum += v;
+            ++count;
+        }
+        void merge(const dbc_group_partial & p)
+        {
+            if(p.count == 0)
+                return;
+            if(count == 0 || p.min < min)
+                min = p.min;
+            if(count == 0 || p.max > max)
+                max = p.max;
+            sum += p.sum;
+            count += p.count;
+        }
+    };
+
+    /* Groups of keys from low to low + range, one slot per key */
+    template <typename T>
+    class dbc_direct_groups
+    {
+    private:
+        int                                 m_low;
+        std::vector<dbc_group_partial<T>>   m_groups;
+
+    public:
+        dbc_direct_groups(int low, unsigned int range) : m_low(low), m_groups(range) {}
+
+        dbc_group_partial<T> & at(int key) { return m_groups[static_cast<unsigned int>(key - m_low)]; }
+        void merge(const dbc_direct_groups & g)
+        {
+            for(size_t i = 0; i < m_groups.size(); ++i)
+                m_groups[i].merge(g.m_groups[i]);
+        }
+        /* Call f(key,partial) for every key with rows, in order of key */
+        template <typename F>
+        void for_each(F f) const
+        {
+            for(size_t i = 0; i < m_groups.size(); ++i)
+            {
+                if(m_groups[i].count)
+                    f(static_cast<int>(m_low + static_cast<int64_t>(i)),m_groups[i]);
+            }
+        }
+    };
+
+    /* Groups of any keys, in an open addressing hash table of slots into the groups */
+    template <typename T>
+    class dbc_hashed_groups
+    {
+    private:
+        enum : uint32_t { empty = ~uint32_t(0) };
+
+        std::vector<uint32_t>               m_slots;
+        std::vector<int>                    m_keys;
+        std::vector<dbc_group_partial<T>>   m_groups;
+
+        uint32_t slot_of(int key) const
+        {
+            /* Fibonacci hashing, consecutive keys spread over the table */
+            return static_cast<uint32_t>((static_cast<uint32_t>(key)*UINT64_C(11400714819323198485)) >> 32) &
+                   static_cast<uint32_t>(m_slots.size() - 1);
+        }
+        void grow()
+        {
+            m_slots.assign(m_slots.size()*2,empty);
+            for(uint32_t g = 0; g < m_keys.size(); ++g)
+            {
+                uint32_t s = slot_of(m_keys[g]);
+                while(m_slots[s] != empty)
+                    s = (s + 1) & static_cast<uint32_t>(m_slots.size() - 1);
+                m_slots[s] = g;
+            }
+        }
+
+    public:
+        dbc_hashed_groups() : m_slots(1024,empty), m_keys(), m_groups() {}
+
+        dbc_group_partial<T> & at(int key)
+        {
+            uint32_t s = slot_of(key);
+            for(; m_slots[s] != empty; s = (s + 1) & static_cast<uint32_t>(m_slots.size() - 1))
+            {
+                if(m_keys[m_slots[s]] == key)
+                    return m_groups[m_slots[s]];
+            }
+            m_slots[s] = static_cast<uint32_t>(m_keys.size());
+            m_keys.push_back(key);
+            m_groups.push_back(dbc_group_partial<T>{});
+            dbc_group_partial<T> & group = m_groups.back();
+            /* At most half full */
+            if(m_keys.size()*2 > m_slots.size())
+                grow();
+            return group;
+        }
+        void merge(const dbc_hashed_groups & g)
+        {
+            for(size_t i = 0; i < g.m_keys.size(); ++i)
+                at(g.m_keys[i]).merge(g.m_groups[i]);
+        }
+        /* Call f(key,partial) for every key with rows, in order of key */
+        template <typename F>
+        void for_each(F f) const
+        {
+            std::vector<uint32_t> order(m_keys.size());
+            for(uint32_t g = 0; g < order.size(); ++g)
+                order[g] = g;
+            std::sort(order.begin(),order.end(),[this](uint32_t l, uint32_t r){ return m_keys[l] < m_keys[r]; });
+            for(uint32_t g : order)
+                f(m_keys[g],m_groups[g]);
+        }
+    };
+} // dbc_impl
+
+/* The groups of rows by key, T is the type of the aggregated values, int or float */
+template <typename T>
+class dbc_group_by
+{
+    static_assert(std::is_same<T,int>::value || std::is_same<T,float>::value,"Only int and float columns can be aggregated");
+public:
+    /* One record per group: the key, the number of rows, and the smallest, largest and sum of their values */
+    typedef std::tuple<int,unsigned int,T,T,double> record_t;
+    enum column { KEY, COUNT, MIN, MAX, SUM };
+
+private:
+    enum : unsigned int
+    {
+        rows_per_part = 16384,      /* A multiple of 64, so parts split the words of a row bitmap */
+        max_direct_range = 65536    /* Keys spanning a larger range are hashed */
+    };
+
+    std::vector<record_t>   m_groups;   /* Ordered by key */
+    dbc_reduction<T>        m_total;
+
+    /* Add rows from begin to end (only those set in rows, if given) to groups */
+    template <typename GROUPS>
+    static void accumulate(GROUPS & groups, const int * keys, const T * values, const dbc_row_bitmap * rows,
+                           unsigned int begin, unsigned int end)
+    {
+        if(!rows)
+        {
+            for(unsigned int row = begin; row < end; ++row)
+                groups.at(keys[row]).add(values[row]);
+            return;
+        }
+        const uint64_t * words = rows->words();
+        for(unsigned int w = begin/64; w*64 < end; ++w)
+        {
+            for(uint64_t bits = words[w]; bits; bits &= bits - 1)
+            {
+                const unsigned int row = w*64 + dbc_impl::lowest_bit(bits);
+                groups.at(keys[row]).add(values[row]);
+            }
+        }
+    }
+
+    /* Accumulate the rows in parts, on pool if given, and merge the parts into one */
+    template <typename GROUPS, typename MAKE>
+    static GROUPS accumulate_parts(MAKE make, const int * keys, const T * values, unsigned int n,
+                                   const dbc_row_bitmap * rows, task_pool * pool)
+    {
+        unsigned int parts = (n + rows_per_part - 1)/rows_per_part;
+        /* Every worker and the calling thread take one part, more would only cost more accumulators to merge */
+        if(!pool)
+            parts = 1;
+        else
+            parts = std::max(1u,std::min(parts,pool->size() + 1));
+        const unsigned int part_rows = ((n + parts - 1)/parts + 63)/64*64;
+        std::vector<GROUPS> partials;
+        for(unsigned int p = 0; p < parts; ++p)
+            partials.push_back(make());
+        auto run = [&](unsigned int begin, unsigned int end)
+        {
+            for(unsigned int p = begin; p < end; ++p)
+                accumulate(partials[p],keys,values,rows,p*part_rows,std::min(n,(p + 1)*part_rows));
+        };
+        if(parts > 1)
+            pool->parallel_for(0,parts,1,run);
+        else
+            run(0,parts);
+        for(unsigned int p = 1; p < parts; ++p)
+            partials[0].merge(partials[p]);
+        return std::move(partials[0]);
+    }
+
+    template <typename GROUPS>
+    void collect(const GROUPS & groups)
+    {
+        groups.for_each([this](int key, const dbc_impl::dbc_group_partial<T> & g)
+        {
+            m_groups.push_back(record_t{key,g.count,g.min,g.max,static_cast<double>(g.sum)});
+        });
+    }
+
+public:
+    dbc_group_by() : m_groups(), m_total{0,T{},T{},0.0} {}
+
+    /* Group rows 0 to n by keys[row] and aggregate values[row], only the rows set in rows if given. Parts of the rows
+     * are accumulated on pool if given. */
+    void build(const int * keys, const T * values, unsigned int n, const dbc_row_bitmap * rows = nullptr,
+               task_pool * pool = nullptr)
+    {
+        m_groups.clear();
+        if(n == 0)
+        {
+            m_total = dbc_reduction<T>{0,T{},T{},0.0};
+            return;
+        }
+        const dbc_reduction<int> key_range = dbc_reduce(keys,n);
+        const int64_t range = int64_t(key_range.max) - key_range.min + 1;
+        if(range <= max_direct_range)
+        {
+            const int low = key_range.min;
+            collect(accumulate_parts<dbc_impl::dbc_direct_groups<T>>([low,range]()
+            {
+                return dbc_impl::dbc_direct_groups<T>(low,static_cast<unsigned int>(range));
+            },keys,values,n,rows,pool));
+        }
+        else
+        {
+            collect(accumulate_parts<dbc_impl::dbc_hashed_groups<T>>([]()
+            {
+                return dbc_impl::dbc_hashed_groups<T>{};
+            },keys,values,n,rows,pool));
+        }
+        if(!rows)
+        {
+            m_total = dbc_reduce(values,n);
+            return;
+        }
+        dbc_impl::dbc_group_partial<T> total;
+        for(const record_t & g : m_groups)
+        {
+            dbc_impl::dbc_group_partial<T> p;
+            p.count = std::get<COUNT>(g);
+            p.min = std::get<MIN>(g);
+            p.max = std::get<MAX>(g);
+            p.sum = static_cast<typename dbc_impl::dbc_sum_type<T>::type>(std::get<SUM>(g));
+            total.merge(p);
+        }
+        m_total = dbc_reduction<T>{total.count,total.min,total.max,static_cast<double>(total.sum)};
+    }
+
+    unsigned int count() const { return static_cast<unsigned int>(m_groups.size()); }
+    const record_t & record_at(unsigned int idx) const { return m_groups[idx]; }
+
+    /* The group of key, nullptr if no row has it */
+    const record_t * find(int key) const
+    {
+        auto it = std::lower_bound(m_groups.begin(),m_groups.end(),key,[](const record_t & g, int k)
+        {
+            return std::get<KEY>(g) < k;
+        });
+        return it != m_groups.end() && std::get<KEY>(*it) == key ? &*it : nullptr;
+    }
+
+    /* The aggregate of all grouped rows */
+    const dbc_reduction<T> & total() const { return m_total; }
+};
+
+#endif // DBC_AGGREGATE_H
@@ -0,0 +1,251 @@
+#ifndef DBC_BITMAP_INDEX_H
+#define DBC_BITMAP_INDEX_H
+
+#include <vector>
+#include <tuple>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+#include "dbc_sort.h"
+#include "dbc_filter.h"
+
+/*
+ *  Bitmap indices of integer columns with few distinct values
+ *
+ *  A bitmap index has the rows of every distinct value of a column (and of every bit of the values, for columns of
+ *  flags) as a set of rows. Rows of an equality or an IN list are then the union of a few sets, no rows are tested.
+ *
+ *  The sets are compressed like roaring bitmaps: the rows are split by their upper 16 bits into containers of up to
+ *  65536 rows. A container with few rows is a sorted array of their lower 16 bits, one with more than 4096 rows (where
+ *  the array would take more than 8kB) a bitmap of all 65536 rows.
+ */
+
+class dbc_roaring_bitmap
+{
+private:
+    enum : unsigned int { max_array = 4096, bitmap_words = 65536/64 };
+
+    struct container
+    {
+        uint16_t                high;
+        unsigned int            count;
+        std::vector<uint16_t>   array;  /* The lower bits of the rows, while there are at most max_array */
+        std::vector<uint64_t>   bitmap; /* Else a bit for each of the 65536 rows */
+    };
+
+    std::vector<container>  m_containers;   /* Ordered by high */
+    unsigned int            m_count;
+
+    const container * find(uint16_t high) const
+    {
+        auto it = std::lower_bound(m_containers.begin(),m_containers.end(),high,[](const container & c, uint16_t h)
+        {
+            return c.high < h;
+        });
+        return it != m_containers.end() && it->high == high ? &*it : nullptr;
+    }
+
+public:
+    dbc_roaring_bitmap() : m_containers(), m_count(0) {}
+
+    /* Rows must be added in ascending order */
+    void push_back(uint32_t row)
+    {
+        const uint16_t high = static_cast<uint16_t>(row >> 16);
+        const uint16_t low = static_cast<uint16_t>(row);
+        if(m_containers.empty() || m_containers.back().high != high)
+            m_containers.push_back(container{high,0,{},{}});
+        container & c = m_containers.back();
+        if(c.bitmap.empty())
+        {
+            c.array.push_back(low);
+            if(c.array.size() > max_array)
+            {
+                c.bitmap.assign(bitmap_words,0);
+                for(uint16_t l : c.array)
+                    c.bitmap[l/64] |= uint64_t(1) << (l & 63);
+                c.array = std::vector<uint16_t>{};
+            }
+        }
+        else
+            c.bitmap[low/64] |= uint64_t(1) << (low & 63);
+        ++c.count;
+        ++m_count;
+    }
+
+    unsigned int count() const { return m_count; }
+
+    bool contains(uint32_t row) const
+    {
+        const container * c = find(static_cast<uint16_t>(row >> 16));
+        if(!c)
+            return false;
+        const uint16_t low = static_cast<uint16_t>(row);
+        if(!c->bitmap.empty())
+            return (c->bitmap[low/64] >> (low & 63)) & 1;
+        return std::binary_search(c->array.begin(),c->array.end(),low);
+    }
+
+    /* Call f(row) for every row, in order of row */
+    template <typename F>
+    void for_each(F f) const
+    {
+        for(const container & c : m_containers)
+        {
+            const uint32_t base = uint32_t(c.high) << 16;
+            if(c.bitmap.empty())
+            {
+                for(uint16_t l : c.array)
+                    f(base | l);
+                continue;
+            }
+            for(unsigned int i = 0; i < bitmap_words; ++i)
+            {
+                for(uint64_t w = c.bitmap[i]; w; w &= w - 1)
+                    f(base | (i*64 + dbc_impl::lowest_bit(w)));
+            }
+        }
+    }
+
+    /* Set the rows of this in rows, which must be large enough for all of them */
+    void add_to(dbc_row_bitmap & rows) const
+    {
+        uint64_t * words = rows.words();
+        const unsigned int row_words = (rows.size() + 63)/64;
+        for(const container & c : m_containers)
+        {
+            const unsigned int base = unsigned(c.high)*bitmap_words;
+            if(c.bitmap.empty())
+            {
+                for(uint16_t l : c.array)
+                    words[base + l/64] |= uint64_t(1) << (l & 63);
+                continue;
+            }
+            const unsigned int n = std::min<unsigned int>(bitmap_words,row_words - base);
+            for(unsigned int i = 0; i < n; ++i)
+                words[base + i] |= c.bitmap[i];
+        }
+    }
+
+    /* Approximate size in memory, in bytes */
+    size_t memory() const
+    {
+        size_t bytes = m_containers.size()*sizeof(container);
+        for(const container & c : m_containers)
+            bytes += c.array.size()*sizeof(uint16_t) + c.bitmap.size()*sizeof(uint64_t);
+        return bytes;
+    }
+};
+
+class dbc_bitmap_index
+{
+private:
+    std::vector<int>                    m_values;   /* The distinct values, ascending */
+    std::vector<dbc_roaring_bitmap>     m_rows;     /* The rows of each value */
+    std::vector<dbc_roaring_bitmap>     m_bits;     /* The rows with each bit set */
+    unsigned int                        m_count;
+
+    struct entry
+    {
+        int             value;
+        unsigned int    row;
+    };
+
+public:
+    dbc_bitmap_index() : m_values(), m_rows(), m_bits(32), m_count(0) {}
+
+    /* value_of(row) is the value of row, for rows 0 to n */
+    template <typename VALUE_OF>
+    void build(unsigned int n, VALUE_OF value_of)
+    {
+        std::vector<entry> entries(n);
+        for(unsigned int row = 0; row < n; ++row)
+        {
+            const int v = value_of(row);
+            entries[row] = entry{v,row};
+            for(unsigned int b = 0; b < 32; ++b)
+            {
+                if(static_cast<uint32_t>(v) & (uint32_t(1) << b))
+                    m_bits[b].push_back(row);
+            }
+        }
+        /* Stable, so the rows of each value stay ascending */
+        dbc_impl::radix_sort(entries,[](const entry & e){ return dbc_impl::dbc_radix_key<int>::key(e.value); });
+        for(size_t i = 0; i < entries.size(); ++i)
+        {
+            if(i == 0 || entries[i].value != entries[i-1].value)
+            {
+                m_values.push_back(entries[i].value);
+                m_rows.push_back(dbc_roaring_bitmap{});
+            }
+            m_rows.back().push_back(entries[i].row);
+        }
+        m_count = n;
+    }
+
+    unsigned int count() const { return m_count; }
+    const std::vector<int> & values() const { return m_values; }
+
+    /* The rows of value, nullptr if no row has it */
+    const dbc_roaring_bitmap * rows_of(int value) const
+    {
+        auto it = std::lower_bound(m_values.begin(),m_values.end(),value);
+        if(it == m_values.end() || *it != value)
+            return nullptr;
+        return &m_rows[static_cast<size_t>(it - m_values.begin())];
+    }
+    /* The rows with bit b (0 to 31) set */
+    const dbc_roaring_bitmap & rows_with_bit(unsigned int b) const { return m_bits[b]; }
+
+    /* Set the rows of any of values in rows */
+    void add_rows_of(const std::vector<int> & values, dbc_row_bitmap & rows) const
+    {
+        for(int v : values)
+        {
+            if(const dbc_roaring_bitmap * r = rows_of(v))
+                r->add_to(rows);
+        }
+    }
+    /* Set the rows with some bit of mask in rows */
+    void add_rows_with_any(int mask, dbc_row_bitmap & rows) const
+    {
+        for(unsigned int b = 0; b < 32; ++b)
+        {
+            if(static_cast<uint32_t>(mask) & (uint32_t(1) << b))
+                m_bits[b].add_to(rows);
+        }
+    }
+};
+
+namespace dbc_impl
+{
+    /* The value of an integer column of a row chosen at runtime. source gives the values of the rows, see
+     * dbc_columns.h. */
+    template <typename RECORD, unsigned int I, unsigned int N>
+    struct dbc_int_column
+    {
+        typedef typename std::tuple_element<I,RECORD>::type field_t;
+        template <typename SOURCE>
+        static int get(unsigned int column, const SOURCE & source, unsigned int row)
+        {
+            return column == I ? value(source.template get<I>(row)) : dbc_int_column<RECORD,I+1,N>::get(column,source,row);
+        }
+        static bool is_int(unsigned int column)
+        {
+            return column == I ? std::is_same<field_t,int>::value : dbc_int_column<RECORD,I+1,N>::is_int(column);
+        }
+    private:
+        static int value(int v) { return v; }
+        template <typename T>
+        static int value(const T &) { return 0; }
+    };
+    template <typename RECORD, unsigned int N>
+    struct dbc_int_column<RECORD,N,N>
+    {
+        template <typename SOURCE>
+        static int get(unsigned int, const SOURCE &, unsigned int) { return 0; }
+        static bool is_int(unsigned int) { return false; }
+    };
+} // dbc_impl
+
+#endif // DBC_BITMAP_INDEX_H
@@ -0,0 +1,330 @@
+#ifndef DBC_CACHE_H
+#define DBC_CACHE_H
+
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <tuple>
+#include <string>
+#include <atomic>
+#include <QCoreApplication>
+
+#include "dbc.h"
+#include "dbc_hash.h"
+#include "dbc_record.h"
+#include "dbc_strings.h"
+
+/*
+ *  A persistent cache of built dbc_tables
+ *
+ *  A cache file holds everything a dbc_table computes from its source file: the projected rows, the strings they
+ *  refer to and the rows in key order. It is only used when it was built from a source file with the same size,
+ *  modification time and contents, and with the same projection. Loading it is then a linear pass over the rows,
+ *  no projecting and no sorting, and the string block is used straight from the mapped cache file.
+ *
+ *  Layout, all values are 32 bit:
+ *
+ *      dbc_cache_header
+ *      column_count columns of row_count values (ints and floats as they are, strings as offsets into the string block)
+ *      row_count row indices, in order of their key
+ *      string_block_size bytes of strings, only the ones that are referred to by the rows
+ *
+ *  Records with wider values, such as the pointers of dbc_ptr fields on 64 bit builds, are not cached (see
+ *  dbc_cache::is_supported). Their tables are always projected.
+ */
+
+struct dbc_cache_header
+{
+    uint32_t                magic;
+    uint32_t                version;
+    dbc_source_signature    source;
+    uint64_t                projection_hash;
+    uint32_t                row_count;
+    uint32_t                column_count;
+    uint32_t                string_block_size;
+    uint32_t                reserved;
+};
+
+/* A read-only view of a whole file, memory mapped where possible */
+class dbc_cache_mapping
+{
+private:
+    char *      m_data;
+    size_t      m_size;
+    bool        m_mapped;
+public:
+    dbc_cache_mapping() : m_data(nullptr), m_size(0), m_mapped(false) {}
+    ~dbc_cache_mapping()
+    {
+#ifdef Q_OS_UNIX
+        if(m_mapped)
+        {
+            ::munmap(m_data,m_size);
+            return;
+        }
+#endif
+        delete [] m_data;
+    }
+    dbc_cache_mapping(const dbc_cache_mapping&) = delete;
+    dbc_cache_mapping& operator=(const dbc_cache_mapping&) = delete;
+
+    bool open(const std::string & path)
+    {
+#ifdef Q_OS_UNIX
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+        struct stat st;
+        if(::fstat(fd,&st) != 0 || st.st_size <= 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        void * p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(p == MAP_FAILED)
+            return false;
+        m_data = static_cast<char*>(p);
+        m_size = static_cast<size_t>(st.st_size);
+        m_mapped = true;
+        return true;
+#else
+        std::ifstream file(path, std::ios::in|std::ios::binary|std::ios::ate);
+        if(!file.is_open())
+            return false;
+        m_size = static_cast<size_t>(file.tellg());
+        m_data = new char [m_size];
+        file.seekg(0, std::ios::beg);
+        file.read(m_data,static_cast<std::streamsize>(m_size));
+        return static_cast<bool>(file);
+#endif
+    }
+
+    const char * data() const { return m_data; }
+    size_t size() const { return m_size; }
+};
+
+namespace dbc_impl
+{
+    template <typename T>
+    struct dbc_cache_field
+    {
+        /* Only 32 bit values can be cached */
+        static constexpr bool is_supported = sizeof(T) == sizeof(uint32_t);
+        static uint32_t encode(const T & value, dbc_string_compactor &)
+        {
+            uint32_t u;
+            memcpy(&u,&value,sizeof(u));
+            return u;
+        }
+        static T decode(uint32_t u, const char *)
+        {
+            T value;
+            memcpy(&value,&u,sizeof(u));
+            return value;
+        }
+        static bool is_valid(uint32_t, uint32_t) { return true; }
+    };
+    template <>
+    struct dbc_cache_field<const char*>
+    {
+        static constexpr bool is_supported = true;
+        static uint32_t encode(const char * value, dbc_string_compactor & strings)
+        {
+            return strings.intern(value);
+        }
+        static const char * decode(uint32_t u, const char * string_block)
+        {
+            return string_block + u;
+        }
+        /* The offset of a string must be within the block */
+        static bool is_valid(uint32_t u, uint32_t string_block_size) { return u < string_block_size; }
+    };
+
+    template <typename RECORD, unsigned int I, unsigned int N>
+    struct dbc_cache_columns
+    {
+        typedef typename std::tuple_element<I,RECORD>::type field_t;
+        static constexpr bool is_supported = dbc_cache_field<field_t>::is_supported && dbc_cache_columns<RECORD,I+1,N>::is_supported;
+        static void encode(const RECORD & r, unsigned int row, unsigned int rows, uint32_t * columns, dbc_string_compactor & strings)
+        {
+            columns[I*rows + row] = dbc_cache_field<field_t>::encode(std::get<I>(r),strings);
+            dbc_cache_columns<RECORD,I+1,N>::encode(r,row,rows,columns,strings);
+        }
+        static void decode(RECORD & r, unsigned int row, unsigned int rows, const uint32_t * columns, const char * string_block)
+        {
+            std::get<I>(r) = dbc_cache_field<field_t>::decode(columns[I*rows + row],string_block);
+            dbc_cache_columns<RECORD,I+1,N>::decode(r,row,rows,columns,string_block);
+        }
+        static bool is_valid(const uint32_t * columns, unsigned int rows, uint32_t string_block_size)
+        {
+            const uint32_t * column = columns + size_t(I)*rows;
+            for(unsigned int row = 0; row < rows; ++row)
+            {
+                if(!dbc_cache_field<field_t>::is_valid(column[row],string_block_size))
+                    return false;
+            }
+            return dbc_cache_columns<RECORD,I+1,N>::is_valid(columns,rows,string_block_size);
+        }
+    };
+    template <typename RECORD, unsigned int N>
+    struct dbc_cache_columns<RECORD,N,N>
+    {
+        static constexpr bool is_supported = true;
+        static void encode(const RECORD &, unsigned int, unsigned int, uint32_t *, dbc_string_compactor &){}
+        static void decode(RECORD &, unsigned int, unsigned int, const uint32_t *, const char *){}
+        static bool is_valid(const uint32_t *, unsigned int, uint32_t) { return true; }
+    };
+
+    template <typename F>
+    struct dbc_field_hash;
+    template <size_t BYTES, dbc_field_type T>
+    struct dbc_field_hash<dbc_field<BYTES,T>>
+    {
+        static uint64_t hash(uint64_t h)
+        {
+            return hash_value(static_cast<uint64_t>(T),hash_value(BYTES,h));
+        }
+    };
+
+    /* Identifies a projection by the layout of the source record and the fields that are projected */
+    template <typename RECORD_TYPE, typename M>
+    struct dbc_projection_hash;
+    template <typename RECORD_TYPE, size_t ... NS>
+    struct dbc_projection_hash<RECORD_TYPE,tmp::tuple_i<NS...>>
+    {
+        static uint64_t hash(unsigned int key_column)
+        {
+            uint64_t h = hash_value(RECORD_TYPE::size,hash_value(RECORD_TYPE::number_of_fields));
+            const uint64_t fields[] = { hash_value(NS,dbc_field_hash<typename RECORD_TYPE::template field_type<NS>>::hash(hash_seed))... };
+            for(uint64_t f : fields)
+                h = hash_value(f,h);
+            return hash_value(key_column,h);
+        }
+    };
+} // dbc_impl
+
+template <typename RECORD>
+struct dbc_cache
+{
+    static constexpr uint32_t magic = 0x43444357; /* "WCDC" */
+    static constexpr uint32_t version = 1;
+    static constexpr unsigned int column_count = std::tuple_size<RECORD>::value;
+    /* Every value of RECORD fits in 32 bits, else load and save fail */
+    static constexpr bool is_supported = dbc_impl::dbc_cache_columns<RECORD,0,column_count>::is_supported;
+
+    /* Read rows, key order and strings from the cache file at path, if it matches source and projection_hash */
+    static bool load(const std::string & path, const dbc_source_signature & source, uint64_t projection_hash,
+                     std::vector<RECORD> & rows, std::vector<unsigned int> & key_order, std::shared_ptr<const char> & strings)
+    {
+        if(!is_supported)
+            return false;
+        std::shared_ptr<dbc_cache_mapping> mapping = std::make_shared<dbc_cache_mapping>();
+        if(!mapping->open(path) || mapping->size() < sizeof(dbc_cache_header))
+            return false;
+        dbc_cache_header h;
+        memcpy(&h,mapping->data(),sizeof(h));
+        if(h.magic != magic || h.version != version || h.column_count != column_count ||
+           h.source.size != source.size || h.source.modified != source.modified || h.source.hash != source.hash ||
+           h.projection_hash != projection_hash)
+            return false;
+        const size_t values = size_t(h.row_count)*(column_count + 1);
+        if(mapping->size() != sizeof(dbc_cache_header) + values*sizeof(uint32_t) + h.string_block_size)
+            return false;
+
+        const uint32_t * columns = reinterpret_cast<const uint32_t*>(mapping->data() + sizeof(dbc_cache_header));
+        const uint32_t * order = columns + size_t(h.row_count)*column_count;
+        const char * string_block = reinterpret_cast<const char*>(order + h.row_count);
+        /* A damaged file of the right size must not make the rows refer outside of it */
+        if(!is_valid(h,columns,order,string_block))
+            return false;
+
+        rows.resize(h.row_count);
+        for(unsigned int i = 0; i < h.row_count; ++i)
+            dbc_impl::dbc_cache_columns<RECORD,0,column_count>::decode(rows[i],i,h.row_count,columns,string_block);
+        key_order.assign(order,order + h.row_count);
+        /* The strings stay in the mapping, which lives as long as someone refers to them */
+        strings = std::shared_ptr<const char>(mapping,string_block);
+        return true;
+    }
+
+    /* Write rows, key order and the strings referred to by the rows to a cache file at path */
+    static bool save(const std::string & path, const dbc_source_signature & source, uint64_t projection_hash,
+                     const std::vector<RECORD> & rows, const std::vector<unsigned int> & key_order)
+    {
+        if(!is_supported)
+            return false;
+        const unsigned int n = static_cast<unsigned int>(rows.size());
+        std::vector<uint32_t> values(size_t(n)*(column_count + 1));
+        dbc_impl::dbc_string_compactor strings;
+        for(unsigned int i = 0; i < n; ++i)
+            dbc_impl::dbc_cache_columns<RECORD,0,column_count>::encode(rows[i],i,n,values.data(),strings);
+        std::copy(key_order.begin(),key_order.end(),values.begin() + size_t(n)*column_count);
+
+        dbc_cache_header h;
+        memset(&h,0,sizeof(h));
+        h.magic = magic;
+        h.version = version;
+        h.source = source;
+        h.projection_hash = projection_hash;
+        h.row_count = n;
+        h.column_count = column_count;
+        h.string_block_size = static_cast<uint32_t>(strings.block.size());
+
+        /* Write to a temporary file first, so a cache file is either complete or not there at all. Every save has a
+         * temporary file of its own, other instances of the editor or other tables may save the same cache meanwhile. */
+        static std::atomic<unsigned int> saves{0};
+        const std::string tmp_path = path + "." + std::to_string(QCoreApplication::applicationPid()) + "." +
+                                     std::to_string(saves++) + ".tmp";
+        {
+            std::ofstream file(tmp_path, std::ios::out|std::ios::binary|std::ios::trunc);
+            if(!file.is_open())
+                return false;
+            file.write(reinterpret_cast<const char*>(&h),sizeof(h));
+            file.write(reinterpret_cast<const char*>(values.data()),static_cast<std::streamsize>(values.size()*sizeof(uint32_t)));
+            file.write(strings.block.data(),static_cast<std::streamsize>(strings.block.size()));
+            if(!file)
+            {
+                file.close();
+                std::remove(tmp_path.c_str());
+                return false;
+            }
+        }
+        std::remove(path.c_str());
+        if(std::rename(tmp_path.c_str(),path.c_str()) == 0)
+            return true;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+private:
+    /* Every key order entry is a row, each row once, and every string is within the block and terminated there */
+    static bool is_valid(const dbc_cache_header & h, const uint32_t * columns, const uint32_t * order, const char * string_block)
+    {
+        if(h.string_block_size && string_block[h.string_block_size - 1] != '\0')
+            return false;
+        if(!dbc_impl::dbc_cache_columns<RECORD,0,column_count>::is_valid(columns,h.row_count,h.string_block_size))
+            return false;
+        std::vector<bool> seen(h.row_count,false);
+        for(unsigned int i = 0; i < h.row_count; ++i)
+        {
+            if(order[i] >= h.row_count || seen[order[i]])
+                return false;
+            seen[order[i]] = true;
+        }
+        return true;
+    }
+};
+
+template <typename RECORD>
+constexpr uint32_t dbc_cache<RECORD>::magic;
+template <typename RECORD>
+constexpr uint32_t dbc_cache<RECORD>::version;
+template <typename RECORD>
+constexpr unsigned int dbc_cache<RECORD>::column_count;
+template <typename RECORD>
+constexpr bool dbc_cache<RECORD>::is_supported;
+
+#endif // DBC_CACHE_H
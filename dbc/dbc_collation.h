@@ -0,0 +1,233 @@
+#ifndef DBC_COLLATION_H
+#define DBC_COLLATION_H
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+/*
+ *  Collation keys of dbc strings
+ *
+ *  A collation key is a byte string made from a string such that comparing two keys with memcmp orders the strings
+ *  the way a user expects to find them in a list, instead of by their UTF-8 bytes. It is a small subset of the
+ *  Unicode collation algorithm, covering the scripts of the game's locales that have an alphabet:
+ *
+ *      Level 1: the letters without accents and case. Punctuation and symbols come before digits, digits before
+ *               letters. Latin letters with accents are their base letter here, ß is ss, æ is ae and so on.
+ *               Cyrillic comes after Latin, anything else after that by its code point (Hangul, Han...).
+ *      Level 2: the accents, so "resume" < "résumé" < "rg".
+ *      Level 3: the case, lower case first.
+ *
+ *  Every level ends with a separator lower than any weight, so a string comes before all longer strings that start
+ *  with it. Level 1 weights are 3 bytes, all other weights are 1 byte.
+ *
+ *  QCollator would do this for every locale, but its QCollatorSortKey does not give access to the bytes of the key,
+ *  so the keys could not be kept in one arena and compared with memcmp.
+ */
+
+namespace dbc_impl
+{
+    namespace collation
+    {
+        enum accent : unsigned char
+        {
+            NONE = 1, ACUTE, GRAVE, BREVE, CIRCUMFLEX, CARON, RING, DIAERESIS, DOUBLE_ACUTE, TILDE, DOT, STROKE,
+            CEDILLA, OGONEK, MACRON
+        };
+
+        enum : uint32_t
+        {
+            SYMBOL = 0x000100,  /* + code point */
+            DIGIT = 0x001000,   /* + digit */
+            LATIN = 0x002000,   /* + 2*letter */
+            CYRILLIC = 0x003000,/* + code point - 0x400 */
+            OTHER = 0x100000    /* + code point */
+        };
+
+        /* A letter as its base letter, case and accent */
+        struct letter
+        {
+            char    base;   /* 0 if this is not a single letter */
+            bool    upper;
+            accent  mark;
+        };
+
+        inline accent accent_of(char code)
+        {
+            switch(code)
+            {
+            case 'a': return ACUTE;
+            case 'g': return GRAVE;
+            case 'b': return BREVE;
+            case 'c': return CIRCUMFLEX;
+            case 'v': return CARON;
+            case 'r': return RING;
+            case 'd': return DIAERESIS;
+            case 'h': return DOUBLE_ACUTE;
+            case 't': return TILDE;
+            case 'p': return DOT;
+            case 's': return STROKE;
+            case 'e': return CEDILLA;
+            case 'o': return OGONEK;
+            case 'm': return MACRON;
+            }
+            return NONE;
+        }
+
+        /* Latin-1 Supplement and Latin Extended-A letters, from U+00C0 to U+017F. Each letter is its base letter (in
+         * its case) and the code of its accent, see accent_of(). '?' are letters that are expanded, '#' are not
+         * letters. */
+        inline letter latin_letter(uint32_t cp)
+        {
+            static const char bases[] =
+                "AAAAAA?CEEEEIIIIDNOOOOO#OUUUUY#?" "aaaaaa?ceeeeiiiidnooooo#ouuuuy#y"
+                "AaAaAaCcCcCcCcDd" "DdEeEeEeEeEeGgGg" "GgGgHhHhIiIiIiIi" "Ii??JjKkkLlLlLlL"
+                "lLlNnNnNnnNnOoOo" "Oo??RrRrRrSsSsSs" "SsTtTtTtUuUuUuUu" "UuUuWwYyYZzZzZzs";
+            static const char marks[] =
+                "gactdr-egacdgacdstgactd-sgacda--" "gactdr-egacdgacdstgactd-sgacda-d"
+                "mmbbooaaccppvvvv" "ssmmbbppoovvccbb" "ppeeccssttmmbboo" "ps--cceesaaeevvp"
+                "pssaaeevvsssmmbb" "hh--aaeevvaaccee" "vveevvssttmmbbrr" "hhooccccdaappvvs";
+            static_assert(sizeof(bases) == 0x180 - 0xC0 + 1 && sizeof(marks) == sizeof(bases),"One letter per code point.");
+            const char b = bases[cp - 0xC0];
+            if(b == '?' || b == '#')
+                return letter{0,false,NONE};
+            return letter{static_cast<char>(b | 0x20),b >= 'A' && b <= 'Z',accent_of(marks[cp - 0xC0])};
+        }
+
+        /* Decode the code point at s, an invalid byte is taken as a Latin-1 character */
+        inline uint32_t next_code_point(const unsigned char *& s)
+        {
+            const unsigned char c = *s++;
+            unsigned int trailing = c >= 0xF0 && c < 0xF8 ? 3 : c >= 0xE0 ? 2 : c >= 0xC2 && c < 0xE0 ? 1 : 0;
+            if(c >= 0xF8)
+                trailing = 0;
+            uint32_t cp = trailing == 3 ? c & 0x07 : trailing == 2 ? c & 0x0F : trailing == 1 ? c & 0x1F : c;
+            for(unsigned int i = 0; i < trailing; ++i)
+            {
+                if((s[i] & 0xC0) != 0x80)
+                    return c;
+            }
+            for(unsigned int i = 0; i < trailing; ++i)
+                cp = (cp << 6) | (*s++ & 0x3F);
+            return cp;
+        }
+
+        struct key_builder
+        {
+            std::vector<unsigned char> &    primary;
+            std::vector<unsigned char>      secondary;
+            std::vector<unsigned char>      tertiary;
+
+            void add(uint32_t weight, accent mark, bool upper)
+            {
+                primary.push_back(static_cast<unsigned char>(weight >> 16));
+                primary.push_back(static_cast<unsigned char>(weight >> 8));
+                primary.push_back(static_cast<unsigned char>(weight));
+                secondary.push_back(mark);
+                tertiary.push_back(upper ? 2 : 1);
+            }
+            void add_latin(char base, accent mark, bool upper)
+            {
+                add(LATIN + 2*uint32_t(base - 'a'),mark,upper);
+            }
+            void add_expansion(const char * lower, bool upper)
+            {
+                for(; *lower; ++lower)
+                    add_latin(*lower,NONE,upper);
+            }
+
+            void add(uint32_t cp)
+            {
+                if(cp >= '0' && cp <= '9')
+                    add(DIGIT + (cp - '0'),NONE,false);
+                else if(cp >= 'a' && cp <= 'z')
+                    add_latin(static_cast<char>(cp),NONE,false);
+                else if(cp >= 'A' && cp <= 'Z')
+                    add_latin(static_cast<char>(cp | 0x20),NONE,true);
+                else if(cp < 0xC0 || cp == 0xD7 || cp == 0xF7)
+                    add(SYMBOL + cp,NONE,false);
+                else if(cp < 0x180)
+                {
+                    const letter l = latin_letter(cp);
+                    if(l.base)
+                        add_latin(l.base,l.mark,l.upper);
+                    else if(cp == 0xC6 || cp == 0xE6)
+                        add_expansion("ae",cp == 0xC6);
+                    else if(cp == 0xDF)
+                        add_expansion("ss",false);
+                    else if(cp == 0xDE || cp == 0xFE)
+                        add(LATIN + 2*26,NONE,cp == 0xDE); /* Thorn, after z */
+                    else if(cp == 0x132 || cp == 0x133)
+                        add_expansion("ij",cp == 0x132);
+                    else
+                        add_expansion("oe",cp == 0x152);
+                }
+                else if(cp >= 0x400 && cp < 0x460)
+                {
+                    const bool upper = cp < 0x430;
+                    if(cp < 0x410)
+                        cp += 0x50;
+                    else if(cp < 0x430)
+                        cp += 0x20;
+                    if(cp == 0x451) /* ё is е with a diaeresis */
+                        add(CYRILLIC + 0x35,DIAERESIS,upper);
+                    else
+                        add(CYRILLIC + (cp - 0x400),NONE,upper);
+                }
+                else
+                    add(OTHER + cp,NONE,false);
+            }
+        };
+    } // collation
+
+    /* Append the collation key of the UTF-8 string s to key */
+    inline void append_collation_key(const char * s, std::vector<unsigned char> & key)
+    {
+        collation::key_builder b{key,{},{}};
+        const unsigned char * u = reinterpret_cast<const unsigned char*>(s);
+        while(*u)
+            b.add(collation::next_code_point(u));
+        key.insert(key.end(),3,0);
+        key.insert(key.end(),b.secondary.begin(),b.secondary.end());
+        key.push_back(0);
+        key.insert(key.end(),b.tertiary.begin(),b.tertiary.end());
+    }
+} // dbc_impl
+
+/* The collation keys of the strings of a column, one per row, in one arena */
+class dbc_collation_keys
+{
+private:
+    std::vector<unsigned char>  m_arena;
+    std::vector<uint32_t>       m_offsets;
+public:
+    /* string_of(row) is the string of row, for rows 0 to n */
+    template <typename STRING_OF>
+    void build(unsigned int n, STRING_OF string_of)
+    {
+        m_arena.clear();
+        m_offsets.assign(1,0);
+        m_offsets.reserve(n+1);
+        for(unsigned int row = 0; row < n; ++row)
+        {
+            dbc_impl::append_collation_key(string_of(row),m_arena);
+            m_offsets.push_back(static_cast<uint32_t>(m_arena.size()));
+        }
+    }
+
+    const unsigned char * key(unsigned int row) const { return m_arena.data() + m_offsets[row]; }
+    size_t size(unsigned int row) const { return m_offsets[row+1] - m_offsets[row]; }
+    unsigned int count() const { return static_cast<unsigned int>(m_offsets.size()) - 1; }
+
+    /* <0, 0 or >0 as the string of row l collates before, the same as or after the string of row r */
+    int compare(unsigned int l, unsigned int r) const
+    {
+        const size_t ls = size(l);
+        const size_t rs = size(r);
+        const int c = memcmp(key(l),key(r),ls < rs ? ls : rs);
+        return c != 0 ? c : (ls < rs ? -1 : ls > rs ? 1 : 0);
+    }
+};
+
+#endif // DBC_COLLATION_H
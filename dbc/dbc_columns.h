@@ -0,0 +1,152 @@
+#ifndef DBC_COLUMNS_H
+#define DBC_COLUMNS_H
+
+#include <vector>
+#include <tuple>
+#include <cstdint>
+#include <utility>
+#include "../resource/task_pool.h"
+
+/*
+ *  Columnar storage of the records of a dbc_table
+ *
+ *  The records of a table are tuples, stored one after the other. A scan of one column then reads every other column
+ *  too, as they share the cache lines. Stored by column, each column is one array of its values in order of row, so
+ *  a scan of a column reads only that column. Strings are stored as their offset in the string block of the table,
+ *  4 bytes instead of a pointer.
+ *
+ *  The columns are a copy: the table keeps its records too, since views and joins hand out references to them. So a
+ *  table stored by column takes about twice the memory, in exchange for faster scans.
+ *
+ *  The algorithms on the rows of a table (sorts, searches, filters) read values through a source, which gives the
+ *  value of column I of a row either from the records or from the columns.
+ */
+
+/* The values of a column of type T, in order of row */
+template <typename T>
+struct dbc_column_array
+{
+    std::vector<T>  values;
+
+    void build(unsigned int n, const char *) { values.resize(n); }
+    void set(unsigned int row, T value, const char *) { values[row] = value; }
+    T at(unsigned int row) const { return values[row]; }
+    void clear() { values.clear(); }
+};
+template <>
+struct dbc_column_array<const char*>
+{
+    const char *            strings;    /* The string block the offsets are in */
+    std::vector<uint32_t>   offsets;
+
+    dbc_column_array() : strings(nullptr), offsets() {}
+    void build(unsigned int n, const char * string_block)
+    {
+        strings = string_block;
+        offsets.resize(n);
+    }
+    void set(unsigned int row, const char * value, const char *)
+    {
+        offsets[row] = static_cast<uint32_t>(value - strings);
+    }
+    const char * at(unsigned int row) const { return strings + offsets[row]; }
+    void clear()
+    {
+        strings = nullptr;
+        offsets.clear();
+    }
+};
+
+namespace dbc_impl
+{
+    /* Values of the records stored as tuples */
+    template <typename RECORD>
+    struct dbc_row_source
+    {
+        const std::vector<RECORD> & records;
+
+        template <unsigned int I>
+        const typename std::tuple_element<I,RECORD>::type & get(unsigned int row) const { return std::get<I>(records[row]); }
+    };
+
+    template <typename COLUMNS, typename RECORD, unsigned int I, unsigned int N>
+    struct dbc_transpose
+    {
+        static void build(COLUMNS & columns, const std::vector<RECORD> & records, const char * string_block, task_pool * pool)
+        {
+            auto & column = std::get<I>(columns);
+            const unsigned int n = static_cast<unsigned int>(records.size());
+            column.build(n,string_block);
+            auto copy = [&column,&records,string_block](unsigned int begin, unsigned int end)
+            {
+                for(unsigned int row = begin; row < end; ++row)
+                    column.set(row,std::get<I>(records[row]),string_block);
+            };
+            if(pool)
+                pool->parallel_for(0,n,16384,copy);
+            else
+                copy(0,n);
+            dbc_transpose<COLUMNS,RECORD,I+1,N>::build(columns,records,string_block,pool);
+        }
+        static void clear(COLUMNS & columns)
+        {
+            std::get<I>(columns).clear();
+            dbc_transpose<COLUMNS,RECORD,I+1,N>::clear(columns);
+        }
+    };
+    template <typename COLUMNS, typename RECORD, unsigned int N>
+    struct dbc_transpose<COLUMNS,RECORD,N,N>
+    {
+        static void build(COLUMNS &, const std::vector<RECORD> &, const char *, task_pool *){}
+        static void clear(COLUMNS &){}
+    };
+} // dbc_impl
+
+template <typename RECORD>
+class dbc_columns;
+
+template <typename ... TS>
+class dbc_columns<std::tuple<TS...>>
+{
+private:
+    typedef std::tuple<TS...>                       record_t;
+    typedef std::tuple<dbc_column_array<TS>...>     columns_t;
+    enum { column_count = sizeof...(TS) };
+
+    columns_t       m_columns;
+    unsigned int    m_size;
+
+    template <size_t ... IS>
+    record_t record(unsigned int row, std::index_sequence<IS...>) const
+    {
+        return record_t{std::get<IS>(m_columns).at(row)...};
+    }
+
+public:
+    dbc_columns() : m_columns(), m_size(0) {}
+
+    /* Copy the columns out of records, whose strings are in string_block. The columns are copied on pool if given. */
+    void build(const std::vector<record_t> & records, const char * string_block, task_pool * pool = nullptr)
+    {
+        dbc_impl::dbc_transpose<columns_t,record_t,0,column_count>::build(m_columns,records,string_block,pool);
+        m_size = static_cast<unsigned int>(records.size());
+    }
+    void clear()
+    {
+        dbc_impl::dbc_transpose<columns_t,record_t,0,column_count>::clear(m_columns);
+        m_size = 0;
+    }
+
+    unsigned int size() const { return m_size; }
+
+    template <unsigned int I>
+    const dbc_column_array<typename std::tuple_element<I,record_t>::type> & column() const { return std::get<I>(m_columns); }
+
+    template <unsigned int I>
+    typename std::tuple_element<I,record_t>::type get(unsigned int row) const { return std::get<I>(m_columns).at(row); }
+
+    /* The record of row, put together from the columns */
+    record_t record(unsigned int row) const { return record(row,std::make_index_sequence<column_count>{}); }
+};
+
+#endif // DBC_COLUMNS_H
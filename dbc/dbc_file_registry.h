@@ -0,0 +1,106 @@
+#ifndef DBC_FILE_REGISTRY_H
+#define DBC_FILE_REGISTRY_H
+
+#include <map>
+#include <memory>
+#include "../directory.h"
+#include "../resource/resource_graph.h"
+#include "dbc.h"
+
+/*
+ *  Hands out shared dbc_files, keyed by their path
+ *
+ *  Every resource that is derived from a dbc file acquires the file here, instead of having its own dbc_file. The
+ *  first acquire of a path creates the file and declares it on the resource graph; later acquires get the same file
+ *  and the same graph node. So the file is loaded once, however many tables are built from it, and since all of
+ *  those tables are declared as dependents of the one node, the graph discards the file data as soon as the last of
+ *  them is built.
+ *
+ *  The dbc_file object itself lives as long as someone, including the graph, holds a dbc_shared_file to it.
+ *  All files must be acquired before the resource graph is started.
+ */
+
+struct dbc_file_registry_entry_base
+{
+    virtual ~dbc_file_registry_entry_base(){}
+};
+
+template <typename DBC_FILE>
+struct dbc_file_registry_entry : public dbc_file_registry_entry_base
+{
+    typedef dbc_file<DBC_FILE>              file_type;
+    typedef typename file_type::view        view_type;
+
+    file_type                   file;
+    view_type                   view;
+    resource_graph::node_id     node;
+
+    dbc_file_registry_entry() : file(), view(file()), node(0) {}
+};
+
+template <typename DBC_FILE>
+class dbc_shared_file
+{
+private:
+    typedef dbc_file_registry_entry<DBC_FILE> entry_type;
+    std::shared_ptr<entry_type> m_entry;
+public:
+    typedef typename entry_type::file_type  file_type;
+    typedef typename entry_type::view_type  view_type;
+
+    dbc_shared_file(std::shared_ptr<entry_type> entry) : m_entry(std::move(entry)) {}
+
+    const file_type &       file() const { return m_entry->file; }
+    const view_type &       view() const { return m_entry->view; }
+    /* The graph node loading the file, declare everything built from the file as derived from this node */
+    resource_graph::node_id node() const { return m_entry->node; }
+    /* How many holders share this file */
+    long                    use_count() const { return m_entry.use_count(); }
+};
+
+class dbc_file_registry
+{
+private:
+    dbc_directory                                                   m_directory;
+    std::map<QString,std::weak_ptr<dbc_file_registry_entry_base>>  m_entries;
+
+public:
+    dbc_file_registry(const configuration & cfg) :
+        m_directory(cfg),
+        m_entries()
+    {
+    }
+    ~dbc_file_registry(){}
+
+    dbc_file_registry(const dbc_file_registry&) = delete;
+    dbc_file_registry& operator=(const dbc_file_registry&) = delete;
+
+    const dbc_directory & directory() const { return m_directory; }
+
+    /* Get the file described by DBC_FILE, declaring it on graph if no one holds it yet.
+     * Each path must always be acquired with the same description. */
+    template <typename DBC_FILE>
+    dbc_shared_file<DBC_FILE> acquire(resource_graph & graph, dbc_load_mode mode = dbc_load_mode::MAP)
+    {
+        typedef dbc_file_registry_entry<DBC_FILE> entry_type;
+        const QString path = m_directory.path() + QString{"/"} + QString{DBC_FILE::file_name.get_data()} + QString{".dbc"};
+
+        auto it = m_entries.find(path);
+        if(it != m_entries.end())
+        {
+            std::shared_ptr<dbc_file_registry_entry_base> existing = (*it).second.lock();
+            if(existing)
+                return dbc_shared_file<DBC_FILE>{std::static_pointer_cast<entry_type>(existing)};
+        }
+
+        std::shared_ptr<entry_type> entry = std::make_shared<entry_type>();
+        entry->file.configure(m_directory,mode);
+        /* The graph holds on to the file too, until it is done with it */
+        entry->node = graph.add_node(resource_lane::IO,[entry](){ entry->file.load(); });
+        graph.set_release(entry->node,[entry](){ entry->file.discard(); });
+        m_entries[path] = entry;
+        return dbc_shared_file<DBC_FILE>{entry};
+    }
+};
+
+#endif // DBC_FILE_REGISTRY_H
@@ -0,0 +1,162 @@
+#ifndef DBC_FILTER_H
+#define DBC_FILTER_H
+
+#include <vector>
+#include <cstdint>
+#include <string>
+#include "dbc_record.h"
+#include "dbc_search.h"
+
+/*
+ *  Filtering the rows of a dbc_table
+ *
+ *  A filter is a bitmap with one bit per row of the table, set for the rows that pass. Refining a filter with a
+ *  predicate on a column only tests the rows whose bit is still set, and clears the bits of those that fail, so typing
+ *  a longer query or narrowing a range gets cheaper the fewer rows are left. Filters of the same table combine by
+ *  and-ing or or-ing their bitmaps, 64 rows at a time.
+ *
+ *  The predicates take the projected value of their column, see the typed predicates below for the common ones.
+ */
+
+namespace dbc_impl
+{
+    /* The index of the lowest set bit of w, w must not be 0 */
+    inline unsigned int lowest_bit(uint64_t w)
+    {
+#if defined(__GNUC__)
+        return static_cast<unsigned int>(__builtin_ctzll(w));
+#else
+        unsigned int b = 0;
+        while(!(w & 1))
+        {
+            w >>= 1;
+            ++b;
+        }
+        return b;
+#endif
+    }
+
+    template <typename T>
+    inline bool field_equal(const T & l, const T & r)
+    {
+        return !dbc_field_less_than<T>{}(l,r) && !dbc_field_less_than<T>{}(r,l);
+    }
+} // dbc_impl
+
+class dbc_row_bitmap
+{
+private:
+    std::vector<uint64_t>   m_words;
+    unsigned int            m_size;
+
+public:
+    dbc_row_bitmap() : m_words(), m_size(0) {}
+    /* n rows, all set if set is true */
+    dbc_row_bitmap(unsigned int n, bool set) : m_words((n + 63)/64,set ? ~uint64_t(0) : 0), m_size(n)
+    {
+        if(set && (n & 63))
+            m_words.back() = (uint64_t(1) << (n & 63)) - 1;
+    }
+
+    unsigned int size() const { return m_size; }
+    /* 64 rows to a word, the lowest bit is the first row */
+    uint64_t * words() { return m_words.data(); }
+    const uint64_t * words() const { return m_words.data(); }
+    bool test(unsigned int row) const { return (m_words[row/64] >> (row & 63)) & 1; }
+    void set(unsigned int row) { m_words[row/64] |= uint64_t(1) << (row & 63); }
+    void reset(unsigned int row) { m_words[row/64] &= ~(uint64_t(1) << (row & 63)); }
+
+    /* The number of set rows */
+    unsigned int count() const
+    {
+        unsigned int n = 0;
+        for(uint64_t w : m_words)
+        {
+            for(; w; w &= w - 1)
+                ++n;
+        }
+        return n;
+    }
+
+    /* Call f(row) for every set row, in order of row */
+    template <typename F>
+    void for_each(F f) const
+    {
+        for(size_t i = 0; i < m_words.size(); ++i)
+        {
+            for(uint64_t w = m_words[i]; w; w &= w - 1)
+                f(static_cast<unsigned int>(i*64 + dbc_impl::lowest_bit(w)));
+        }
+    }
+
+    /* Reset the set rows for which keep(row) is false, keep is not called for the other rows */
+    template <typename KEEP>
+    void retain(KEEP keep)
+    {
+        for(size_t i = 0; i < m_words.size(); ++i)
+        {
+            uint64_t kept = m_words[i];
+            for(uint64_t w = m_words[i]; w; w &= w - 1)
+            {
+                const unsigned int b = dbc_impl::lowest_bit(w);
+                if(!keep(static_cast<unsigned int>(i*64 + b)))
+                    kept &= ~(uint64_t(1) << b);
+            }
+            m_words[i] = kept;
+        }
+    }
+
+    /* Both bitmaps must have the same size */
+    dbc_row_bitmap & operator &= (const dbc_row_bitmap & b)
+    {
+        for(size_t i = 0; i < m_words.size(); ++i)
+            m_words[i] &= b.m_words[i];
+        return *this;
+    }
+    dbc_row_bitmap & operator |= (const dbc_row_bitmap & b)
+    {
+        for(size_t i = 0; i < m_words.size(); ++i)
+            m_words[i] |= b.m_words[i];
+        return *this;
+    }
+};
+
+/* Typed predicates on the value of a column */
+template <typename T>
+struct dbc_equal_to
+{
+    T value;
+    bool operator () (const T & v) const { return dbc_impl::field_equal(v,value); }
+};
+template <typename T>
+struct dbc_less_than
+{
+    T value;
+    bool operator () (const T & v) const { return dbc_impl::dbc_field_less_than<T>{}(v,value); }
+};
+template <typename T>
+struct dbc_greater_than
+{
+    T value;
+    bool operator () (const T & v) const { return dbc_impl::dbc_field_less_than<T>{}(value,v); }
+};
+/* From low to high, both included */
+template <typename T>
+struct dbc_in_range
+{
+    T low;
+    T high;
+    bool operator () (const T & v) const
+    {
+        return !dbc_impl::dbc_field_less_than<T>{}(v,low) && !dbc_impl::dbc_field_less_than<T>{}(high,v);
+    }
+};
+/* Strings containing a substring, ASCII letters match in either case */
+struct dbc_contains
+{
+    std::string folded;
+    explicit dbc_contains(const std::string & substring) : folded(dbc_impl::fold_case(substring.c_str())) {}
+    bool operator () (const char * v) const { return dbc_impl::contains_folded(v,folded); }
+};
+
+#endif // DBC_FILTER_H
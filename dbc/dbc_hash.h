@@ -0,0 +1,42 @@
+#ifndef DBC_HASH_H
+#define DBC_HASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+/*
+ *  A 64 bit hash (FNV-1a, taken 8 bytes at a time) used to tell whether files and projections have changed.
+ *
+ *  It can be computed incrementally, by passing the result of one call as the seed of the next, as long as every
+ *  piece except the last one has a size that is a multiple of 8.
+ */
+
+namespace dbc_impl
+{
+    static constexpr uint64_t hash_seed = 14695981039346656037ull;
+    static constexpr uint64_t hash_prime = 1099511628211ull;
+
+    inline uint64_t hash_bytes(const char * data, size_t size, uint64_t h = hash_seed)
+    {
+        size_t i = 0;
+        for(; i + 8 <= size; i += 8)
+        {
+            uint64_t w;
+            memcpy(&w,data + i,8);
+            h = (h ^ w) * hash_prime;
+        }
+        for(; i < size; ++i)
+        {
+            h = (h ^ static_cast<unsigned char>(data[i])) * hash_prime;
+        }
+        return h;
+    }
+
+    inline uint64_t hash_value(uint64_t value, uint64_t h = hash_seed)
+    {
+        return hash_bytes(reinterpret_cast<const char*>(&value),sizeof(value),h);
+    }
+} // dbc_impl
+
+#endif // DBC_HASH_H
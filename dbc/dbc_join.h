@@ -0,0 +1,169 @@
+#ifndef DBC_JOIN_H
+#define DBC_JOIN_H
+
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <atomic>
+#include "dbc/dbc_table.h"
+#include "resource/task_pool.h"
+
+/*
+ *  Joins of the records of a dbc_table to the records of another they refer to
+ *
+ *  A record refers to another by a foreign key, a column holding the key of a record of the other table (the faction
+ *  of a faction template, the model of a creature display). A join is described like a projection (see
+ *  dbc_projection.h):
+ *
+ *         foreign_key: The column of the foreign key in the referring projection
+ *         columns:     tuple_i of the columns of the referred projection shown with the referring records
+ *
+ *         struct faction_template_faction_join
+ *         {
+ *             static constexpr const faction_template_projection::map_index foreign_key =
+ *                                                                          faction_template_projection::map_index::Faction;
+ *             typedef tmp::tuple_i<1> columns;
+ *         };
+ *
+ *  Once both tables are loaded the join is built: the row of the referred record of every referring row, looked up by
+ *  key once for all rows. A view of the join then shows the referring records followed by the columns of their
+ *  referred records, read through the rows without looking up keys. Records referring to no record show empty values.
+ *
+ *  A join can be built in a resource_graph after both tables, see resource_graph::add_combined.
+ */
+
+namespace dbc_impl
+{
+    /* A value for the columns of missing records */
+    template <typename T>
+    struct dbc_missing_value { static T value() { return T{}; } };
+    template <>
+    struct dbc_missing_value<const char*> { static const char * value() { return ""; } };
+
+    template <typename FROM_RECORD, typename TO_RECORD, typename COLUMNS>
+    struct dbc_join_record;
+    template <typename FROM_RECORD, typename TO_RECORD, size_t ... CS>
+    struct dbc_join_record<FROM_RECORD,TO_RECORD,tmp::tuple_i<CS...>>
+    {
+        typedef std::tuple<typename std::tuple_element<CS,TO_RECORD>::type...>  joined_t;
+        typedef decltype(std::tuple_cat(std::declval<FROM_RECORD>(),std::declval<joined_t>())) type;
+
+        static joined_t columns(const TO_RECORD & to) { return joined_t{std::get<CS>(to)...}; }
+        static joined_t missing() { return joined_t{dbc_missing_value<typename std::tuple_element<CS,TO_RECORD>::type>::value()...}; }
+    };
+} // dbc_impl
+
+template <typename FROM, typename TO, typename JOIN>
+class dbc_join
+{
+private:
+    typedef typename FROM::view::record_t   from_record_t;
+    typedef typename TO::view::record_t     to_record_t;
+    typedef dbc_impl::dbc_join_record<from_record_t,to_record_t,typename JOIN::columns> join_record;
+
+    enum : unsigned int
+    {
+        foreign_key = static_cast<unsigned int>(JOIN::foreign_key),
+        rows_per_task = 16384
+    };
+
+    const FROM &                m_from;
+    const TO &                  m_to;
+    /* Row of the referring table -> row of the referred record, or dbc_no_row */
+    std::vector<unsigned int>   m_rows;
+    /* Set once m_rows is filled, m_rows is only read while it is */
+    std::atomic<bool>           m_built;
+
+public:
+    typedef typename join_record::type record_t;
+
+    dbc_join(const FROM & from, const TO & to) : m_from(from), m_to(to), m_rows(), m_built(false) {}
+
+    /* Build the join, on the calling thread or in ranges of rows on pool. Both tables must be loaded. */
+    void load()
+    {
+        load_impl(nullptr);
+    }
+    void load(task_pool & pool)
+    {
+        load_impl(&pool);
+    }
+
+    bool is_completed() const { return m_built.load(std::memory_order_acquire); }
+
+    /* The row of the record referred to by row of the referring table, or dbc_no_row */
+    unsigned int joined_row(unsigned int row) const
+    {
+        /* Not built (or being rebuilt), or built on earlier loads of the tables */
+        if(!is_completed() || m_rows.size() != m_from.row_count() || row >= m_rows.size() || m_rows[row] >= m_to.row_count())
+            return dbc_no_row;
+        return m_rows[row];
+    }
+
+    /* Call f(referred row, referring row) for every row of the referring table that refers to a record */
+    template <typename F>
+    void for_each_reference(F f) const
+    {
+        if(!is_completed())
+            return;
+        const unsigned int n = static_cast<unsigned int>(m_rows.size());
+        for(unsigned int row = 0; row < n; ++row)
+        {
+            const unsigned int joined = joined_row(row);
+            if(joined != dbc_no_row)
+                f(joined,row);
+        }
+    }
+
+    /* The referring records in the order of a view of the referring table, with the columns of their referred record */
+    class view
+    {
+    private:
+        const dbc_join &        m_join;
+        typename FROM::view     m_from;
+
+    public:
+        typedef typename dbc_join::record_t record_t;
+
+        view(const dbc_join & join, typename FROM::view from) : m_join(join), m_from(std::move(from)) {}
+
+        /* The view of the referring table, which orders and filters this view */
+        typename FROM::view & base() { return m_from; }
+        const typename FROM::view & base() const { return m_from; }
+
+        unsigned int count() const { return m_from.count(); }
+        record_t record_at(unsigned int idx) const
+        {
+            const unsigned int row = m_from.row_at(idx);
+            const unsigned int joined = m_join.joined_row(row);
+            return std::tuple_cat(m_join.m_from.record_of_row(row),
+                                  joined == dbc_no_row ? join_record::missing() : join_record::columns(m_join.m_to.record_of_row(joined)));
+        }
+    };
+
+    /* A view in order of the keys of the referring table */
+    view operator()() const
+    {
+        return view{*this,m_from()};
+    }
+
+private:
+    void load_impl(task_pool * pool)
+    {
+        m_built.store(false,std::memory_order_release);
+        const unsigned int n = m_from.row_count();
+        m_rows.assign(n,dbc_no_row);
+        auto join = [this](unsigned int begin, unsigned int end)
+        {
+            for(unsigned int row = begin; row < end; ++row)
+                m_rows[row] = m_to.row_of_key(std::get<foreign_key>(m_from.record_of_row(row)));
+        };
+        if(pool)
+            pool->parallel_for(0,n,rows_per_task,join);
+        else
+            join(0,n);
+        m_built.store(true,std::memory_order_release);
+    }
+};
+
+#endif // DBC_JOIN_H
@@ -15,6 +15,15 @@ struct dbc_field
 {
 };
 
+/* The locales of a localized string (a dbc_string of more than 4 bytes), in the order of their offsets. The offsets
+ * are followed by a flags word. */
+enum class dbc_locale
+{
+    enUS,koKR,frFR,deDE,zhCN,zhTW,esES,esMX,ruRU,
+
+    SIZE = 16
+};
+
 template <size_t BYTES>
 using dbc_ptr = dbc_field<BYTES,dbc_field_type::PTR>;
 template <size_t BYTES>
@@ -40,7 +49,7 @@ namespace dbc_impl
     struct dbc_field_store_type<dbc_field<BYTES,dbc_field_type::PTR>>
     {
         typedef int* type;
-        static type from_data(const char * data, const char * )
+        static type from_data(const char * data, const char *, dbc_locale)
         {
             return *reinterpret_cast<const type*>(data);
         }
@@ -49,7 +58,7 @@ namespace dbc_impl
     struct dbc_field_store_type<dbc_field<BYTES,dbc_field_type::INT>>
     {
         typedef int type;
-        static type from_data(const char * data, const char * )
+        static type from_data(const char * data, const char *, dbc_locale)
         {
             return *reinterpret_cast<const type*>(data);
         }
@@ -58,7 +67,7 @@ namespace dbc_impl
     struct dbc_field_store_type<dbc_field<BYTES,dbc_field_type::FLOAT>>
     {
         typedef float type;
-        static type from_data(const char * data, const char * )
+        static type from_data(const char * data, const char *, dbc_locale)
         {
             return *reinterpret_cast<const type*>(data);
         }
@@ -68,8 +77,16 @@ namespace dbc_impl
     struct dbc_field_store_type<dbc_field<BYTES,dbc_field_type::STRING>>
     {
         typedef const char* type;
-        static type from_data(const char * data, const char * base)
+        /* Strings of other locales than enUS fall back to enUS where they are empty */
+        static type from_data(const char * data, const char * base, dbc_locale locale)
         {
+            const unsigned int slot = static_cast<unsigned int>(locale);
+            if(slot != 0 && slot < BYTES/4 - 1)
+            {
+                const unsigned int offset = reinterpret_cast<const unsigned int*>(data)[slot];
+                if(offset != 0 && base[offset] != '\0')
+                    return base + offset;
+            }
             return base + *reinterpret_cast<const unsigned int*>(data);
         }
     };
@@ -106,24 +123,16 @@ namespace dbc_impl
     template <>
     struct dbc_field_less_than<const char *>
     {
+        /* Orders by the bytes of the strings, a string before the longer strings starting with it.
+         * See dbc_collation.h for the order users expect. */
         bool operator () (const char * ls, const char * rs) const
         {
             unsigned int offset = 0;
-            while(ls[offset] != '\0' && rs[offset] != '\0')
+            while(ls[offset] != '\0' && ls[offset] == rs[offset])
             {
-                if(ls[offset] < rs[offset])
-                {
-                    return true;
-                }
-                else if(ls[offset] > rs[offset])
-                {
-                    return false;
-                }
                 ++offset;
             }
-            if(ls[offset] == rs[offset])
-                return true;
-            return false;
+            return static_cast<unsigned char>(ls[offset]) < static_cast<unsigned char>(rs[offset]);
         }
     };
 
@@ -180,6 +189,24 @@ namespace dbc_impl
         static constexpr bool value = tmp::math::sum<is_string<FS>::value ...> > 0;
     };
 
+    template <typename F>
+    struct is_localized_string
+    {
+        enum { value = false };
+    };
+
+    template <size_t BYTES>
+    struct is_localized_string<dbc_field<BYTES,dbc_field_type::STRING>>
+    {
+        enum { value = BYTES > 4 };
+    };
+
+    template <typename ... FS>
+    struct has_localized_string
+    {
+        static constexpr bool value = tmp::math::sum<is_localized_string<FS>::value ...> > 0;
+    };
+
 }
 
 template <typename T>
@@ -194,6 +221,7 @@ struct dbc_record<tmp::tuple_t<FS...>>
     static constexpr unsigned int number_of_fields = sizeof...(FS);
     static constexpr unsigned int size = tmp::math::sum_tuple<tmp::tuple_i<dbc_field_size<FS>...>>;
     static constexpr bool has_string = dbc_impl::has_string<FS...>::value;
+    static constexpr bool has_localized_string = dbc_impl::has_localized_string<FS...>::value;
 
     template <unsigned int N>
     struct field_offset
@@ -268,9 +296,9 @@ namespace dbc_impl
         typedef typename RECORD_TYPE:: template tuple_t<tmp::tuple_i<NS...>> tuple_t;
         template <unsigned int N>
         using dbc_field_type = dbc_field_store_type<typename RECORD_TYPE::template field_type<N>>;
-        static inline tuple_t project(const VIEW & view, unsigned int idx, const char* string_block)
+        static inline tuple_t project(const VIEW & view, unsigned int idx, const char* string_block, dbc_locale locale)
         {
-            return tuple_t{dbc_field_type<NS>::from_data(view.template field<NS>(idx),string_block)...};
+            return tuple_t{dbc_field_type<NS>::from_data(view.template field<NS>(idx),string_block,locale)...};
         }
     };
 } // dbc_impl
@@ -0,0 +1,534 @@
+#include "dbc_scan.h"
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define DBC_SCAN_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    typedef void (*int_kernel)(const int *, unsigned int, int, int, uint64_t *);
+    typedef void (*float_kernel)(const float *, unsigned int, float, float, uint64_t *);
+
+    inline bool any_bits(int v, int a) { return (v & a) != 0; }
+    inline bool any_bits(float, float) { return false; }
+    inline bool all_bits(int v, int a) { return (v & a) == a; }
+    inline bool all_bits(float, float) { return false; }
+
+    /* The switch is on a constant, so only its case is left */
+    template <dbc_scan_op OP, typename T>
+    inline bool passes(T v, T a, T b)
+    {
+        switch(OP)
+        {
+        case dbc_scan_op::EQUAL:        return v == a;
+        case dbc_scan_op::NOT_EQUAL:    return v != a;
+        case dbc_scan_op::LESS:         return v < a;
+        case dbc_scan_op::GREATER:      return v > a;
+        case dbc_scan_op::IN_RANGE:     return a <= v && v <= b;
+        case dbc_scan_op::ANY_BITS:     return any_bits(v,a);
+        case dbc_scan_op::ALL_BITS:     return all_bits(v,a);
+        }
+        return false;
+    }
+
+    /* The values from begin to n, whose bits are in words[begin/64] and on. begin is a multiple of 64. */
+    template <dbc_scan_op OP, typename T>
+    void scan_scalar(const T * values, unsigned int begin, unsigned int n, T a, T b, uint64_t * words)
+    {
+        for(unsigned int w = begin/64; w*64 < n; ++w)
+        {
+            uint64_t word = 0;
+            const unsigned int end = n - w*64 < 64 ? n - w*64 : 64;
+            for(unsigned int j = 0; j < end; ++j)
+                word |= uint64_t(passes<OP>(values[w*64 + j],a,b)) << j;
+            words[w] = word;
+        }
+    }
+
+    /* Fold values from begin to n into r, whose count, min and max are those of the values before begin */
+    template <typename T, typename SUM>
+    void reduce_scalar(const T * values, unsigned int begin, unsigned int n, dbc_reduction<T> & r, SUM & sum)
+    {
+        for(unsigned int i = begin; i < n; ++i)
+        {
+            const T v = values[i];
+            if(r.count == 0 || v < r.min)
+                r.min = v;
+            if(r.count == 0 || v > r.max)
+                r.max = v;
+            sum += v;
+            ++r.count;
+        }
+    }
+
+    namespace scalar
+    {
+        dbc_reduction<int> reduce(const int * values, unsigned int n)
+        {
+            dbc_reduction<int> r{0,0,0,0.0};
+            int64_t sum = 0;
+            reduce_scalar(values,0,n,r,sum);
+            r.sum = static_cast<double>(sum);
+            return r;
+        }
+        dbc_reduction<float> reduce(const float * values, unsigned int n)
+        {
+            dbc_reduction<float> r{0,0.0f,0.0f,0.0};
+            reduce_scalar(values,0,n,r,r.sum);
+            return r;
+        }
+
+        template <dbc_scan_op OP, typename T>
+        void scan(const T * values, unsigned int n, T a, T b, uint64_t * words)
+        {
+            scan_scalar<OP>(values,0,n,a,b,words);
+        }
+
+        template <typename T>
+        void (*kernel(dbc_scan_op op))(const T *, unsigned int, T, T, uint64_t *)
+        {
+            switch(op)
+            {
+            case dbc_scan_op::EQUAL:        return &scan<dbc_scan_op::EQUAL,T>;
+            case dbc_scan_op::NOT_EQUAL:    return &scan<dbc_scan_op::NOT_EQUAL,T>;
+            case dbc_scan_op::LESS:         return &scan<dbc_scan_op::LESS,T>;
+            case dbc_scan_op::GREATER:      return &scan<dbc_scan_op::GREATER,T>;
+            case dbc_scan_op::IN_RANGE:     return &scan<dbc_scan_op::IN_RANGE,T>;
+            case dbc_scan_op::ANY_BITS:     return &scan<dbc_scan_op::ANY_BITS,T>;
+            case dbc_scan_op::ALL_BITS:     return &scan<dbc_scan_op::ALL_BITS,T>;
+            }
+            return &scan<dbc_scan_op::EQUAL,T>;
+        }
+    } // scalar
+} // namespace
+
+#ifdef DBC_SCAN_X86
+
+/* The kernels of each instruction set are compiled for it alone, and only called once the processor is known to
+ * support it. A lanes struct compares as many values as fit a register and gives a bit per value. */
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+namespace
+{
+namespace sse2
+{
+    struct int_lanes
+    {
+        typedef int     value_t;
+        typedef __m128i vec;
+        enum { lanes = 4, all = 0xf };
+
+        static vec set1(int a) { return _mm_set1_epi32(a); }
+        static vec load(const int * p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+        static unsigned int bits(vec m) { return static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(m))); }
+
+        template <dbc_scan_op OP>
+        static unsigned int test(vec v, vec a, vec b)
+        {
+            switch(OP)
+            {
+            case dbc_scan_op::EQUAL:        return bits(_mm_cmpeq_epi32(v,a));
+            case dbc_scan_op::NOT_EQUAL:    return ~bits(_mm_cmpeq_epi32(v,a)) & all;
+            case dbc_scan_op::LESS:         return bits(_mm_cmplt_epi32(v,a));
+            case dbc_scan_op::GREATER:      return bits(_mm_cmpgt_epi32(v,a));
+            case dbc_scan_op::IN_RANGE:     return ~bits(_mm_or_si128(_mm_cmplt_epi32(v,a),_mm_cmpgt_epi32(v,b))) & all;
+            case dbc_scan_op::ANY_BITS:     return ~bits(_mm_cmpeq_epi32(_mm_and_si128(v,a),_mm_setzero_si128())) & all;
+            case dbc_scan_op::ALL_BITS:     return bits(_mm_cmpeq_epi32(_mm_and_si128(v,a),a));
+            }
+            return 0;
+        }
+    };
+
+    struct float_lanes
+    {
+        typedef float   value_t;
+        typedef __m128  vec;
+        enum { lanes = 4, all = 0xf };
+
+        static vec set1(float a) { return _mm_set1_ps(a); }
+        static vec load(const float * p) { return _mm_loadu_ps(p); }
+        static unsigned int bits(vec m) { return static_cast<unsigned int>(_mm_movemask_ps(m)); }
+
+        template <dbc_scan_op OP>
+        static unsigned int test(vec v, vec a, vec b)
+        {
+            switch(OP)
+            {
+            case dbc_scan_op::EQUAL:        return bits(_mm_cmpeq_ps(v,a));
+            case dbc_scan_op::NOT_EQUAL:    return bits(_mm_cmpneq_ps(v,a));
+            case dbc_scan_op::LESS:         return bits(_mm_cmplt_ps(v,a));
+            case dbc_scan_op::GREATER:      return bits(_mm_cmpgt_ps(v,a));
+            case dbc_scan_op::IN_RANGE:     return bits(_mm_and_ps(_mm_cmpge_ps(v,a),_mm_cmple_ps(v,b)));
+            case dbc_scan_op::ANY_BITS:
+            case dbc_scan_op::ALL_BITS:     return 0;
+            }
+            return 0;
+        }
+    };
+
+    template <typename LANES, dbc_scan_op OP>
+    void scan(const typename LANES::value_t * values, unsigned int n, typename LANES::value_t a, typename LANES::value_t b,
+              uint64_t * words)
+    {
+        const typename LANES::vec va = LANES::set1(a);
+        const typename LANES::vec vb = LANES::set1(b);
+        const unsigned int full = n/64;
+        for(unsigned int w = 0; w < full; ++w)
+        {
+            uint64_t word = 0;
+            for(unsigned int j = 0; j < 64; j += LANES::lanes)
+                word |= uint64_t(LANES::template test<OP>(LANES::load(values + w*64 + j),va,vb)) << j;
+            words[w] = word;
+        }
+        scan_scalar<OP>(values,full*64,n,a,b,words);
+    }
+
+    template <typename LANES>
+    void (*kernel(dbc_scan_op op))(const typename LANES::value_t *, unsigned int, typename LANES::value_t, typename LANES::value_t, uint64_t *)
+    {
+        switch(op)
+        {
+        case dbc_scan_op::EQUAL:        return &scan<LANES,dbc_scan_op::EQUAL>;
+        case dbc_scan_op::NOT_EQUAL:    return &scan<LANES,dbc_scan_op::NOT_EQUAL>;
+        case dbc_scan_op::LESS:         return &scan<LANES,dbc_scan_op::LESS>;
+        case dbc_scan_op::GREATER:      return &scan<LANES,dbc_scan_op::GREATER>;
+        case dbc_scan_op::IN_RANGE:     return &scan<LANES,dbc_scan_op::IN_RANGE>;
+        case dbc_scan_op::ANY_BITS:     return &scan<LANES,dbc_scan_op::ANY_BITS>;
+        case dbc_scan_op::ALL_BITS:     return &scan<LANES,dbc_scan_op::ALL_BITS>;
+        }
+        return &scan<LANES,dbc_scan_op::EQUAL>;
+    }
+
+    dbc_reduction<int> reduce(const int * values, unsigned int n)
+    {
+        dbc_reduction<int> r{0,0,0,0.0};
+        int64_t sum = 0;
+        if(n >= 4)
+        {
+            __m128i mn = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+            __m128i mx = mn;
+            __m128i sums = _mm_setzero_si128();
+            unsigned int i = 0;
+            for(; i + 4 <= n; i += 4)
+            {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+                const __m128i lt = _mm_cmplt_epi32(v,mn);
+                const __m128i gt = _mm_cmpgt_epi32(v,mx);
+                mn = _mm_or_si128(_mm_and_si128(lt,v),_mm_andnot_si128(lt,mn));
+                mx = _mm_or_si128(_mm_and_si128(gt,v),_mm_andnot_si128(gt,mx));
+                /* Sign extended to 64 bits, so the sum does not overflow */
+                const __m128i sign = _mm_srai_epi32(v,31);
+                sums = _mm_add_epi64(sums,_mm_unpacklo_epi32(v,sign));
+                sums = _mm_add_epi64(sums,_mm_unpackhi_epi32(v,sign));
+            }
+            int lanes_min[4], lanes_max[4];
+            int64_t lanes_sum[2];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes_min),mn);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes_max),mx);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes_sum),sums);
+            r = dbc_reduction<int>{i,lanes_min[0],lanes_max[0],0.0};
+            for(unsigned int l = 1; l < 4; ++l)
+            {
+                r.min = std::min(r.min,lanes_min[l]);
+                r.max = std::max(r.max,lanes_max[l]);
+            }
+            sum = lanes_sum[0] + lanes_sum[1];
+            reduce_scalar(values,i,n,r,sum);
+        }
+        else
+            reduce_scalar(values,0,n,r,sum);
+        r.sum = static_cast<double>(sum);
+        return r;
+    }
+
+    dbc_reduction<float> reduce(const float * values, unsigned int n)
+    {
+        dbc_reduction<float> r{0,0.0f,0.0f,0.0};
+        if(n < 4)
+        {
+            reduce_scalar(values,0,n,r,r.sum);
+            return r;
+        }
+        __m128 mn = _mm_loadu_ps(values);
+        __m128 mx = mn;
+        __m128d sums = _mm_setzero_pd();
+        unsigned int i = 0;
+        for(; i + 4 <= n; i += 4)
+        {
+            const __m128 v = _mm_loadu_ps(values + i);
+            mn = _mm_min_ps(mn,v);
+            mx = _mm_max_ps(mx,v);
+            sums = _mm_add_pd(sums,_mm_add_pd(_mm_cvtps_pd(v),_mm_cvtps_pd(_mm_movehl_ps(v,v))));
+        }
+        float lanes_min[4], lanes_max[4];
+        double lanes_sum[2];
+        _mm_storeu_ps(lanes_min,mn);
+        _mm_storeu_ps(lanes_max,mx);
+        _mm_storeu_pd(lanes_sum,sums);
+        r = dbc_reduction<float>{i,lanes_min[0],lanes_max[0],lanes_sum[0] + lanes_sum[1]};
+        for(unsigned int l = 1; l < 4; ++l)
+        {
+            r.min = std::min(r.min,lanes_min[l]);
+            r.max = std::max(r.max,lanes_max[l]);
+        }
+        reduce_scalar(values,i,n,r,r.sum);
+        return r;
+    }
+} // sse2
+} // namespace
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace
+{
+namespace avx2
+{
+    struct int_lanes
+    {
+        typedef int     value_t;
+        typedef __m256i vec;
+        enum { lanes = 8, all = 0xff };
+
+        static vec set1(int a) { return _mm256_set1_epi32(a); }
+        static vec load(const int * p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static unsigned int bits(vec m) { return static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(m))); }
+
+        template <dbc_scan_op OP>
+        static unsigned int test(vec v, vec a, vec b)
+        {
+            switch(OP)
+            {
+            case dbc_scan_op::EQUAL:        return bits(_mm256_cmpeq_epi32(v,a));
+            case dbc_scan_op::NOT_EQUAL:    return ~bits(_mm256_cmpeq_epi32(v,a)) & all;
+            case dbc_scan_op::LESS:         return bits(_mm256_cmpgt_epi32(a,v));
+            case dbc_scan_op::GREATER:      return bits(_mm256_cmpgt_epi32(v,a));
+            case dbc_scan_op::IN_RANGE:     return ~bits(_mm256_or_si256(_mm256_cmpgt_epi32(a,v),_mm256_cmpgt_epi32(v,b))) & all;
+            case dbc_scan_op::ANY_BITS:     return ~bits(_mm256_cmpeq_epi32(_mm256_and_si256(v,a),_mm256_setzero_si256())) & all;
+            case dbc_scan_op::ALL_BITS:     return bits(_mm256_cmpeq_epi32(_mm256_and_si256(v,a),a));
+            }
+            return 0;
+        }
+    };
+
+    struct float_lanes
+    {
+        typedef float   value_t;
+        typedef __m256  vec;
+        enum { lanes = 8, all = 0xff };
+
+        static vec set1(float a) { return _mm256_set1_ps(a); }
+        static vec load(const float * p) { return _mm256_loadu_ps(p); }
+        static unsigned int bits(vec m) { return static_cast<unsigned int>(_mm256_movemask_ps(m)); }
+
+        template <dbc_scan_op OP>
+        static unsigned int test(vec v, vec a, vec b)
+        {
+            switch(OP)
+            {
+            case dbc_scan_op::EQUAL:        return bits(_mm256_cmp_ps(v,a,_CMP_EQ_OQ));
+            case dbc_scan_op::NOT_EQUAL:    return bits(_mm256_cmp_ps(v,a,_CMP_NEQ_UQ));
+            case dbc_scan_op::LESS:         return bits(_mm256_cmp_ps(v,a,_CMP_LT_OQ));
+            case dbc_scan_op::GREATER:      return bits(_mm256_cmp_ps(v,a,_CMP_GT_OQ));
+            case dbc_scan_op::IN_RANGE:     return bits(_mm256_and_ps(_mm256_cmp_ps(v,a,_CMP_GE_OQ),_mm256_cmp_ps(v,b,_CMP_LE_OQ)));
+            case dbc_scan_op::ANY_BITS:
+            case dbc_scan_op::ALL_BITS:     return 0;
+            }
+            return 0;
+        }
+    };
+
+    template <typename LANES, dbc_scan_op OP>
+    void scan(const typename LANES::value_t * values, unsigned int n, typename LANES::value_t a, typename LANES::value_t b,
+              uint64_t * words)
+    {
+        const typename LANES::vec va = LANES::set1(a);
+        const typename LANES::vec vb = LANES::set1(b);
+        const unsigned int full = n/64;
+        for(unsigned int w = 0; w < full; ++w)
+        {
+            uint64_t word = 0;
+            for(unsigned int j = 0; j < 64; j += LANES::lanes)
+                word |= uint64_t(LANES::template test<OP>(LANES::load(values + w*64 + j),va,vb)) << j;
+            words[w] = word;
+        }
+        scan_scalar<OP>(values,full*64,n,a,b,words);
+    }
+
+    template <typename LANES>
+    void (*kernel(dbc_scan_op op))(const typename LANES::value_t *, unsigned int, typename LANES::value_t, typename LANES::value_t, uint64_t *)
+    {
+        switch(op)
+        {
+        case dbc_scan_op::EQUAL:        return &scan<LANES,dbc_scan_op::EQUAL>;
+        case dbc_scan_op::NOT_EQUAL:    return &scan<LANES,dbc_scan_op::NOT_EQUAL>;
+        case dbc_scan_op::LESS:         return &scan<LANES,dbc_scan_op::LESS>;
+        case dbc_scan_op::GREATER:      return &scan<LANES,dbc_scan_op::GREATER>;
+        case dbc_scan_op::IN_RANGE:     return &scan<LANES,dbc_scan_op::IN_RANGE>;
+        case dbc_scan_op::ANY_BITS:     return &scan<LANES,dbc_scan_op::ANY_BITS>;
+        case dbc_scan_op::ALL_BITS:     return &scan<LANES,dbc_scan_op::ALL_BITS>;
+        }
+        return &scan<LANES,dbc_scan_op::EQUAL>;
+    }
+
+    dbc_reduction<int> reduce(const int * values, unsigned int n)
+    {
+        dbc_reduction<int> r{0,0,0,0.0};
+        int64_t sum = 0;
+        if(n >= 8)
+        {
+            __m256i mn = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+            __m256i mx = mn;
+            __m256i sums = _mm256_setzero_si256();
+            unsigned int i = 0;
+            for(; i + 8 <= n; i += 8)
+            {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+                mn = _mm256_min_epi32(mn,v);
+                mx = _mm256_max_epi32(mx,v);
+                sums = _mm256_add_epi64(sums,_mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+                sums = _mm256_add_epi64(sums,_mm256_cvtepi32_epi64(_mm256_extracti128_si256(v,1)));
+            }
+            int lanes_min[8], lanes_max[8];
+            int64_t lanes_sum[4];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes_min),mn);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes_max),mx);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes_sum),sums);
+            r = dbc_reduction<int>{i,lanes_min[0],lanes_max[0],0.0};
+            for(unsigned int l = 1; l < 8; ++l)
+            {
+                r.min = std::min(r.min,lanes_min[l]);
+                r.max = std::max(r.max,lanes_max[l]);
+            }
+            sum = lanes_sum[0] + lanes_sum[1] + lanes_sum[2] + lanes_sum[3];
+            reduce_scalar(values,i,n,r,sum);
+        }
+        else
+            reduce_scalar(values,0,n,r,sum);
+        r.sum = static_cast<double>(sum);
+        return r;
+    }
+
+    dbc_reduction<float> reduce(const float * values, unsigned int n)
+    {
+        dbc_reduction<float> r{0,0.0f,0.0f,0.0};
+        if(n < 8)
+        {
+            reduce_scalar(values,0,n,r,r.sum);
+            return r;
+        }
+        __m256 mn = _mm256_loadu_ps(values);
+        __m256 mx = mn;
+        __m256d sums = _mm256_setzero_pd();
+        unsigned int i = 0;
+        for(; i + 8 <= n; i += 8)
+        {
+            const __m256 v = _mm256_loadu_ps(values + i);
+            mn = _mm256_min_ps(mn,v);
+            mx = _mm256_max_ps(mx,v);
+            sums = _mm256_add_pd(sums,_mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)),
+                                                    _mm256_cvtps_pd(_mm256_extractf128_ps(v,1))));
+        }
+        float lanes_min[8], lanes_max[8];
+        double lanes_sum[4];
+        _mm256_storeu_ps(lanes_min,mn);
+        _mm256_storeu_ps(lanes_max,mx);
+        _mm256_storeu_pd(lanes_sum,sums);
+        r = dbc_reduction<float>{i,lanes_min[0],lanes_max[0],lanes_sum[0] + lanes_sum[1] + lanes_sum[2] + lanes_sum[3]};
+        for(unsigned int l = 1; l < 8; ++l)
+        {
+            r.min = std::min(r.min,lanes_min[l]);
+            r.max = std::max(r.max,lanes_max[l]);
+        }
+        reduce_scalar(values,i,n,r,r.sum);
+        return r;
+    }
+} // avx2
+} // namespace
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif // DBC_SCAN_X86
+
+dbc_simd dbc_scan_simd()
+{
+#ifdef DBC_SCAN_X86
+    static const dbc_simd supported = __builtin_cpu_supports("avx2") ? dbc_simd::AVX2 :
+                                      __builtin_cpu_supports("sse2") ? dbc_simd::SSE2 : dbc_simd::SCALAR;
+    return supported;
+#else
+    return dbc_simd::SCALAR;
+#endif
+}
+
+void dbc_scan(const int * values, unsigned int n, dbc_scan_op op, int a, int b, uint64_t * words, dbc_simd simd)
+{
+    if(static_cast<int>(simd) > static_cast<int>(dbc_scan_simd()))
+        simd = dbc_scan_simd();
+    int_kernel k = scalar::kernel<int>(op);
+#ifdef DBC_SCAN_X86
+    if(simd == dbc_simd::AVX2)
+        k = avx2::kernel<avx2::int_lanes>(op);
+    else if(simd == dbc_simd::SSE2)
+        k = sse2::kernel<sse2::int_lanes>(op);
+#endif
+    k(values,n,a,b,words);
+}
+
+void dbc_scan(const float * values, unsigned int n, dbc_scan_op op, float a, float b, uint64_t * words, dbc_simd simd)
+{
+    if(static_cast<int>(simd) > static_cast<int>(dbc_scan_simd()))
+        simd = dbc_scan_simd();
+    float_kernel k = scalar::kernel<float>(op);
+#ifdef DBC_SCAN_X86
+    if(simd == dbc_simd::AVX2)
+        k = avx2::kernel<avx2::float_lanes>(op);
+    else if(simd == dbc_simd::SSE2)
+        k = sse2::kernel<sse2::float_lanes>(op);
+#endif
+    k(values,n,a,b,words);
+}
+
+dbc_reduction<int> dbc_reduce(const int * values, unsigned int n, dbc_simd simd)
+{
+    if(static_cast<int>(simd) > static_cast<int>(dbc_scan_simd()))
+        simd = dbc_scan_simd();
+#ifdef DBC_SCAN_X86
+    if(simd == dbc_simd::AVX2)
+        return avx2::reduce(values,n);
+    if(simd == dbc_simd::SSE2)
+        return sse2::reduce(values,n);
+#endif
+    return scalar::reduce(values,n);
+}
+
+dbc_reduction<float> dbc_reduce(const float * values, unsigned int n, dbc_simd simd)
+{
+    if(static_cast<int>(simd) > static_cast<int>(dbc_scan_simd()))
+        simd = dbc_scan_simd();
+#ifdef DBC_SCAN_X86
+    if(simd == dbc_simd::AVX2)
+        return avx2::reduce(values,n);
+    if(simd == dbc_simd::SSE2)
+        return sse2::reduce(values,n);
+#endif
+    return scalar::reduce(values,n);
+}
@@ -0,0 +1,57 @@
+#ifndef DBC_SCAN_H
+#define DBC_SCAN_H
+
+#include <cstdint>
+
+/*
+ *  Scans of integer and float columns
+ *
+ *  A scan compares every value of a column against constants and sets a bit per passing value in a bitmap, 64 values
+ *  to a word, in the layout of dbc_row_bitmap. The comparisons are done with SSE2 or AVX2, 4 or 8 values at a time,
+ *  as the processor supports it, and else one value at a time. The instruction set is picked when the program runs.
+ *
+ *  A reduction gives the count, smallest, largest and sum of the values of a column in the same way.
+ */
+
+enum class dbc_scan_op
+{
+    EQUAL,          /* v == a */
+    NOT_EQUAL,      /* v != a */
+    LESS,           /* v < a */
+    GREATER,        /* v > a */
+    IN_RANGE,       /* a <= v <= b */
+    ANY_BITS,       /* v & a != 0, integers only */
+    ALL_BITS        /* v & a == a, integers only */
+};
+
+enum class dbc_simd
+{
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+/* The best instruction set the processor supports */
+dbc_simd dbc_scan_simd();
+
+/* Set bit i of words to whether values[i] passes op, for i from 0 to n. words holds (n + 63)/64 words. simd is lowered
+ * to what the processor supports. A float never passes ANY_BITS and ALL_BITS. */
+void dbc_scan(const int * values, unsigned int n, dbc_scan_op op, int a, int b, uint64_t * words,
+              dbc_simd simd = dbc_scan_simd());
+void dbc_scan(const float * values, unsigned int n, dbc_scan_op op, float a, float b, uint64_t * words,
+              dbc_simd simd = dbc_scan_simd());
+
+/* The sum is exact for integers. For floats it is summed in doubles, in an order that depends on the instruction set. */
+template <typename T>
+struct dbc_reduction
+{
+    unsigned int    count;
+    T               min;    /* T{} when there are no values */
+    T               max;
+    double          sum;
+};
+
+dbc_reduction<int> dbc_reduce(const int * values, unsigned int n, dbc_simd simd = dbc_scan_simd());
+dbc_reduction<float> dbc_reduce(const float * values, unsigned int n, dbc_simd simd = dbc_scan_simd());
+
+#endif // DBC_SCAN_H
@@ -0,0 +1,418 @@
+#ifndef DBC_SEARCH_H
+#define DBC_SEARCH_H
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <tuple>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include "dbc_sort.h"
+
+/*
+ *  Substring search in string columns of a dbc_table
+ *
+ *  A trigram index maps every three consecutive bytes of the strings of a column (a trigram) to the rows with that
+ *  trigram, in order of row. A row contains a query only if it has all trigrams of the query, so the rows to check
+ *  are the intersection of the rows of the query's trigrams, which is usually a handful of rows.
+ *
+ *  A prefix index has the rows of a column ordered by their string. The rows whose string starts with some prefix
+ *  are then a range of it, and the range of the prefix extended by one character is found by two binary searches
+ *  within the range of the prefix. So completing a prefix while it is typed never looks at rows that were ruled out.
+ *
+ *  A fuzzy search ranks rows by the edits (insertions, deletions and substitutions of a byte) that make the query a
+ *  part of their string. Myers' bit-parallel algorithm keeps a column of the edit distance matrix in the bits of two
+ *  words, so each byte of a string costs a dozen word operations regardless of the length of the query. The rows are
+ *  scanned in the background by the workers of a task_pool, which queue the matches in dbc_fuzzy_results for the
+ *  thread that started the search.
+ *
+ *  Searches ignore the case of ASCII letters. The indices keep a copy of the strings in lower case, to check the
+ *  candidates against.
+ */
+
+namespace dbc_impl
+{
+    inline char fold_case(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+    }
+
+    inline std::string fold_case(const char * s)
+    {
+        std::string folded{s};
+        for(char & c : folded)
+            c = fold_case(c);
+        return folded;
+    }
+
+    /* folded_query must be folded already */
+    inline bool contains_folded(const char * s, const std::string & folded_query)
+    {
+        const size_t m = folded_query.size();
+        for(; *s; ++s)
+        {
+            size_t i = 0;
+            while(i < m && s[i] && fold_case(s[i]) == folded_query[i])
+                ++i;
+            if(i == m)
+                return true;
+        }
+        return m == 0;
+    }
+
+    inline uint32_t trigram(const char * s)
+    {
+        return (uint32_t(static_cast<unsigned char>(s[0])) << 16) |
+               (uint32_t(static_cast<unsigned char>(s[1])) << 8) |
+                uint32_t(static_cast<unsigned char>(s[2]));
+    }
+
+    template <typename T>
+    struct dbc_string_of
+    {
+        static const char * get(const T &) { return nullptr; }
+    };
+    template <>
+    struct dbc_string_of<const char*>
+    {
+        static const char * get(const char * s) { return s; }
+    };
+
+    /* The string of a column of a row chosen at runtime, or nullptr if that column does not hold strings. source gives
+     * the values of the rows, see dbc_columns.h. */
+    template <typename RECORD, unsigned int I, unsigned int N>
+    struct dbc_string_column
+    {
+        typedef typename std::tuple_element<I,RECORD>::type field_t;
+        template <typename SOURCE>
+        static const char * get(unsigned int column, const SOURCE & source, unsigned int row)
+        {
+            return column == I ? dbc_string_of<field_t>::get(source.template get<I>(row)) :
+                                 dbc_string_column<RECORD,I+1,N>::get(column,source,row);
+        }
+        static bool is_string(unsigned int column)
+        {
+            return column == I ? std::is_same<field_t,const char*>::value : dbc_string_column<RECORD,I+1,N>::is_string(column);
+        }
+    };
+    template <typename RECORD, unsigned int N>
+    struct dbc_string_column<RECORD,N,N>
+    {
+        template <typename SOURCE>
+        static const char * get(unsigned int, const SOURCE &, unsigned int) { return nullptr; }
+        static bool is_string(unsigned int) { return false; }
+    };
+} // dbc_impl
+
+class dbc_trigram_index
+{
+private:
+    std::vector<char>           m_text;         /* The strings in lower case, each ended by '\0' */
+    std::vector<uint32_t>       m_text_offsets; /* Row -> offset in m_text */
+    std::vector<uint32_t>       m_trigrams;     /* The distinct trigrams, ordered */
+    std::vector<uint32_t>       m_postings_offsets;
+    std::vector<uint32_t>       m_postings;     /* The rows of m_trigrams[i] are m_postings[m_postings_offsets[i]...] */
+
+    struct posting
+    {
+        uint32_t    trigram;
+        uint32_t    row;
+    };
+
+    /* The rows with trigram t, as a range in m_postings */
+    bool rows_of(uint32_t t, const uint32_t *& begin, const uint32_t *& end) const
+    {
+        auto it = std::lower_bound(m_trigrams.begin(),m_trigrams.end(),t);
+        if(it == m_trigrams.end() || *it != t)
+            return false;
+        const size_t i = static_cast<size_t>(it - m_trigrams.begin());
+        begin = m_postings.data() + m_postings_offsets[i];
+        end = m_postings.data() + m_postings_offsets[i+1];
+        return true;
+    }
+
+public:
+    /* string_of(row) is the string of row, for rows 0 to n */
+    template <typename STRING_OF>
+    void build(unsigned int n, STRING_OF string_of)
+    {
+        m_text.clear();
+        m_text_offsets.resize(n);
+        std::vector<posting> postings;
+        for(unsigned int row = 0; row < n; ++row)
+        {
+            m_text_offsets[row] = static_cast<uint32_t>(m_text.size());
+            for(const char * s = string_of(row); *s; ++s)
+                m_text.push_back(dbc_impl::fold_case(*s));
+            m_text.push_back('\0');
+            const char * folded = m_text.data() + m_text_offsets[row];
+            const size_t length = m_text.size() - m_text_offsets[row] - 1;
+            for(size_t i = 0; i + 3 <= length; ++i)
+                postings.push_back(posting{dbc_impl::trigram(folded + i),row});
+        }
+
+        /* Stable, so the rows of each trigram stay in order */
+        dbc_impl::radix_sort(postings,[](const posting & p){ return p.trigram; });
+
+        m_trigrams.clear();
+        m_postings_offsets.clear();
+        m_postings.clear();
+        for(size_t i = 0; i < postings.size(); ++i)
+        {
+            if(i == 0 || postings[i].trigram != postings[i-1].trigram)
+            {
+                m_trigrams.push_back(postings[i].trigram);
+                m_postings_offsets.push_back(static_cast<uint32_t>(m_postings.size()));
+            }
+            else if(postings[i].row == postings[i-1].row)
+                continue;
+            m_postings.push_back(postings[i].row);
+        }
+        m_postings_offsets.push_back(static_cast<uint32_t>(m_postings.size()));
+    }
+
+    unsigned int count() const { return static_cast<unsigned int>(m_text_offsets.size()); }
+    const char * folded_string(unsigned int row) const { return m_text.data() + m_text_offsets[row]; }
+
+    /* Call f(row) for every row containing query, in order of row. query must be folded. */
+    template <typename F>
+    void search(const std::string & query, F f) const
+    {
+        const unsigned int n = count();
+        if(query.size() < 3)
+        {
+            for(unsigned int row = 0; row < n; ++row)
+            {
+                if(strstr(folded_string(row),query.c_str()))
+                    f(row);
+            }
+            return;
+        }
+
+        /* Intersect the rows of all trigrams of the query, starting with the least common trigram */
+        std::vector<std::pair<const uint32_t*,const uint32_t*>> lists;
+        for(size_t i = 0; i + 3 <= query.size(); ++i)
+        {
+            const uint32_t * begin;
+            const uint32_t * end;
+            if(!rows_of(dbc_impl::trigram(query.c_str() + i),begin,end))
+                return;
+            lists.push_back(std::make_pair(begin,end));
+        }
+        std::sort(lists.begin(),lists.end(),[](const std::pair<const uint32_t*,const uint32_t*> & l,
+                                               const std::pair<const uint32_t*,const uint32_t*> & r)
+        {
+            return l.second - l.first < r.second - r.first;
+        });
+        std::vector<uint32_t> candidates(lists[0].first,lists[0].second);
+        std::vector<uint32_t> remaining;
+        for(size_t i = 1; i < lists.size() && !candidates.empty(); ++i)
+        {
+            remaining.clear();
+            std::set_intersection(candidates.begin(),candidates.end(),lists[i].first,lists[i].second,std::back_inserter(remaining));
+            candidates.swap(remaining);
+        }
+        /* All trigrams in a row do not make the query, they may be apart */
+        for(uint32_t row : candidates)
+        {
+            if(strstr(folded_string(row),query.c_str()))
+                f(row);
+        }
+    }
+};
+
+/* The rows of a prefix index starting with a prefix of length depth, from begin to end */
+struct dbc_prefix_range
+{
+    unsigned int    begin;
+    unsigned int    end;
+    unsigned int    depth;
+
+    unsigned int size() const { return end - begin; }
+};
+
+class dbc_prefix_index
+{
+private:
+    std::vector<char>           m_text;         /* The strings in lower case, each ended by '\0' */
+    std::vector<uint32_t>       m_text_offsets; /* Row -> offset in m_text */
+    std::vector<unsigned int>   m_rows;         /* The rows, ordered by their string in lower case */
+
+    unsigned char at(unsigned int i, unsigned int depth) const
+    {
+        return static_cast<unsigned char>(m_text[m_text_offsets[m_rows[i]] + depth]);
+    }
+
+public:
+    /* string_of(row) is the string of row, for rows 0 to n. The rows are sorted on pool if given. */
+    template <typename STRING_OF>
+    void build(unsigned int n, STRING_OF string_of, task_pool * pool = nullptr)
+    {
+        m_text.clear();
+        m_text_offsets.resize(n);
+        m_rows.resize(n);
+        for(unsigned int row = 0; row < n; ++row)
+        {
+            m_text_offsets[row] = static_cast<uint32_t>(m_text.size());
+            for(const char * s = string_of(row); *s; ++s)
+                m_text.push_back(dbc_impl::fold_case(*s));
+            m_text.push_back('\0');
+            m_rows[row] = row;
+        }
+        const char * text = m_text.data();
+        const uint32_t * offsets = m_text_offsets.data();
+        parallel_merge_sort(pool,m_rows,[text,offsets](unsigned int l, unsigned int r)
+        {
+            return strcmp(text + offsets[l],text + offsets[r]) < 0;
+        });
+    }
+
+    unsigned int count() const { return static_cast<unsigned int>(m_rows.size()); }
+    /* The row at i in order of the strings */
+    unsigned int row(unsigned int i) const { return m_rows[i]; }
+
+    /* The range of the empty prefix, all rows */
+    dbc_prefix_range all() const { return dbc_prefix_range{0,count(),0}; }
+
+    /* The rows of r whose string goes on with c after the prefix of r, in O(log r.size()) */
+    dbc_prefix_range extend(const dbc_prefix_range & r, char c) const
+    {
+        const unsigned char u = static_cast<unsigned char>(dbc_impl::fold_case(c));
+        if(u == 0)
+            return dbc_prefix_range{r.begin,r.begin,r.depth+1};
+        /* Within r the strings only differ after the prefix, and a string that ends there has '\0' next */
+        unsigned int lo = r.begin;
+        unsigned int hi = r.end;
+        while(lo < hi)
+        {
+            const unsigned int mid = lo + (hi - lo)/2;
+            if(at(mid,r.depth) < u)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        const unsigned int begin = lo;
+        hi = r.end;
+        while(lo < hi)
+        {
+            const unsigned int mid = lo + (hi - lo)/2;
+            if(at(mid,r.depth) <= u)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return dbc_prefix_range{begin,lo,r.depth+1};
+    }
+
+    /* The range of prefix */
+    dbc_prefix_range find(const std::string & prefix) const
+    {
+        dbc_prefix_range r = all();
+        for(size_t i = 0; i < prefix.size() && r.size(); ++i)
+            r = extend(r,prefix[i]);
+        return r;
+    }
+};
+
+struct dbc_fuzzy_match
+{
+    unsigned int    row;
+    unsigned int    distance;
+};
+
+/* The matches of a fuzzy search, queued in batches by the workers scanning the rows and taken by the thread that started
+ * the search, so nothing of that thread (a model, a widget) is touched by the workers. */
+class dbc_fuzzy_results
+{
+private:
+    mutable std::mutex              m_mutex;
+    std::vector<dbc_fuzzy_match>    m_matches;  /* Queued and not taken yet */
+    std::atomic<bool>               m_cancelled;
+    std::atomic<bool>               m_done;
+
+public:
+    dbc_fuzzy_results() : m_mutex(), m_matches(), m_cancelled(false), m_done(false) {}
+
+    /* Queue a batch of matches ranked by distance, called by the workers */
+    void add(const std::vector<dbc_fuzzy_match> & batch)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_matches.insert(m_matches.end(),batch.begin(),batch.end());
+    }
+    /* No more batches will be queued */
+    void finish() { m_done.store(true,std::memory_order_release); }
+
+    /* The matches queued since the last take, one ranked batch after the other */
+    std::vector<dbc_fuzzy_match> take()
+    {
+        std::vector<dbc_fuzzy_match> matches;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        matches.swap(m_matches);
+        return matches;
+    }
+    /* Stop scanning the rows that are not scanned yet. The queued matches can still be taken. */
+    void cancel() { m_cancelled.store(true,std::memory_order_relaxed); }
+    bool is_cancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+    /* The scan is over, a last take() gets the remaining matches */
+    bool is_done() const { return m_done.load(std::memory_order_acquire); }
+};
+
+/* The fewest edits that make a query a part of a string. Queries are cut after 64 bytes, one bit per byte. */
+class dbc_fuzzy_matcher
+{
+private:
+    uint64_t        m_peq[256];     /* Byte -> the positions in the query of the byte */
+    unsigned int    m_length;
+
+public:
+    explicit dbc_fuzzy_matcher(const std::string & query) :
+        m_length(static_cast<unsigned int>(std::min<size_t>(query.size(),64)))
+    {
+        std::fill(std::begin(m_peq),std::end(m_peq),0);
+        for(unsigned int i = 0; i < m_length; ++i)
+        {
+            const unsigned char c = static_cast<unsigned char>(dbc_impl::fold_case(query[i]));
+            m_peq[c] |= uint64_t(1) << i;
+            if(c >= 'a' && c <= 'z')
+                m_peq[c & ~0x20] |= uint64_t(1) << i;
+        }
+    }
+
+    unsigned int length() const { return m_length; }
+
+    unsigned int distance(const char * s) const
+    {
+        if(m_length == 0)
+            return 0;
+        const uint64_t last = uint64_t(1) << (m_length - 1);
+        uint64_t pv = ~uint64_t(0);
+        uint64_t mv = 0;
+        unsigned int score = m_length;
+        unsigned int best = m_length;
+        for(; *s && best; ++s)
+        {
+            const uint64_t eq = m_peq[static_cast<unsigned char>(*s)];
+            const uint64_t xv = eq | mv;
+            const uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+            if(ph & last)
+                ++score;
+            else if(mh & last)
+                --score;
+            /* The match may start anywhere in s, so the first row of the matrix stays 0 */
+            ph <<= 1;
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+            best = std::min(best,score);
+        }
+        return best;
+    }
+};
+
+#endif // DBC_SEARCH_H
@@ -0,0 +1,273 @@
+#ifndef DBC_SORT_H
+#define DBC_SORT_H
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <tuple>
+#include <cstdint>
+#include <cstring>
+#include "dbc_record.h"
+#include "dbc_collation.h"
+#include "../resource/task_pool.h"
+
+/*
+ *  Sorting the rows of a dbc_table by a column
+ *
+ *  The values of the column are copied out of the records together with their row, so the sort compares values
+ *  that lie next to each other in memory instead of going through whole records. The sort is a merge sort: runs of
+ *  the values are sorted by the workers of a task_pool, then merged pairwise, all pairs of a pass at the same time.
+ *
+ *  Columns of 32 bit integers and floats are not compared at all, but radix sorted: four linear passes over the
+ *  values, one per byte. The same sort orders the keys of the key index. Columns of strings are sorted by the
+ *  collation keys of the strings, which are kept with the order of the column.
+ *
+ *  A sorted order is published to a view through a dbc_sort_slot, by whatever thread finished the sort. The view
+ *  takes it over when it wants to, so a view never changes order while it is being read.
+ */
+
+typedef std::vector<unsigned int> dbc_row_order;
+
+/* The order of a view: its rows in order of some column, or none for key order */
+struct dbc_sorted_order
+{
+    std::shared_ptr<const dbc_row_order>    rows;
+    bool                                    descending;
+    unsigned int                            ticket;
+};
+
+/* Where the sorts requested by a view are published */
+struct dbc_sort_slot
+{
+    /* The latest request of the view, orders of earlier requests are not published anymore */
+    std::atomic<unsigned int>               ticket;
+    /* Only accessed with std::atomic_load and std::atomic_store */
+    std::shared_ptr<const dbc_sorted_order> published;
+
+    dbc_sort_slot() : ticket(0), published() {}
+
+    void publish(std::shared_ptr<const dbc_row_order> rows, bool descending, unsigned int t)
+    {
+        const std::shared_ptr<const dbc_sorted_order> order{new dbc_sorted_order{std::move(rows),descending,t}};
+        std::shared_ptr<const dbc_sorted_order> current = std::atomic_load(&published);
+        /* A later request may be published meanwhile, by the view or another sort, which must not be replaced */
+        do
+        {
+            if(t != ticket || (current && current->ticket > t))
+                return;
+        }
+        while(!std::atomic_compare_exchange_weak(&published,&current,order));
+    }
+};
+
+/* Stable sort of v, in runs of grain elements on the workers of pool, or on the calling thread without a pool */
+template <typename T, typename LESS>
+void parallel_merge_sort(task_pool * pool, std::vector<T> & v, LESS less, unsigned int grain = 8192)
+{
+    const unsigned int n = static_cast<unsigned int>(v.size());
+    if(!pool || n <= grain)
+    {
+        std::stable_sort(v.begin(),v.end(),less);
+        return;
+    }
+    const unsigned int runs = (n + grain - 1)/grain;
+    pool->parallel_for(0,runs,1,[&v,&less,n,grain](unsigned int begin, unsigned int end)
+    {
+        for(unsigned int r = begin; r < end; ++r)
+            std::stable_sort(v.begin() + r*grain,v.begin() + std::min(n,(r+1)*grain),less);
+    });
+
+    std::vector<T> buffer(n);
+    std::vector<T> * from = &v;
+    std::vector<T> * to = &buffer;
+    for(unsigned int width = grain; width < n; width *= 2)
+    {
+        const unsigned int pairs = (n + 2*width - 1)/(2*width);
+        pool->parallel_for(0,pairs,1,[from,to,&less,n,width](unsigned int begin, unsigned int end)
+        {
+            for(unsigned int p = begin; p < end; ++p)
+            {
+                const unsigned int lo = p*2*width;
+                const unsigned int mid = std::min(n,lo + width);
+                const unsigned int hi = std::min(n,lo + 2*width);
+                std::merge(from->begin() + lo,from->begin() + mid,from->begin() + mid,from->begin() + hi,to->begin() + lo,less);
+            }
+        });
+        std::swap(from,to);
+    }
+    if(from != &v)
+        v.swap(buffer);
+}
+
+namespace dbc_impl
+{
+    /* Maps values of T to unsigned integers in the same order, for the types that can be radix sorted */
+    template <typename T>
+    struct dbc_radix_key
+    {
+        enum { sortable = false };
+    };
+    template <>
+    struct dbc_radix_key<unsigned int>
+    {
+        enum { sortable = true };
+        static uint32_t key(unsigned int v) { return v; }
+    };
+    template <>
+    struct dbc_radix_key<int>
+    {
+        enum { sortable = true };
+        /* Negative numbers first */
+        static uint32_t key(int v) { return static_cast<uint32_t>(v) ^ 0x80000000u; }
+    };
+    template <>
+    struct dbc_radix_key<float>
+    {
+        enum { sortable = true };
+        /* Positive floats order like their bits once the sign bit is set. Negative floats order backwards, so all of
+         * their bits are flipped. */
+        static uint32_t key(float v)
+        {
+            static_assert(sizeof(float) == sizeof(uint32_t),"Floats must be 32 bit.");
+            uint32_t u;
+            memcpy(&u,&v,sizeof(u));
+            return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+        }
+    };
+
+    /* Stable LSD radix sort of v by key_of(element), a uint32_t. Passes over a byte that is the same in every key
+     * are skipped. */
+    template <typename T, typename KEY_OF>
+    void radix_sort(std::vector<T> & v, KEY_OF key_of)
+    {
+        const size_t n = v.size();
+        if(n < 2)
+            return;
+        size_t counts[4][256] = {};
+        for(const T & e : v)
+        {
+            const uint32_t k = key_of(e);
+            for(unsigned int b = 0; b < 4; ++b)
+                ++counts[b][(k >> (8*b)) & 0xff];
+        }
+        std::vector<T> buffer(n);
+        std::vector<T> * from = &v;
+        std::vector<T> * to = &buffer;
+        for(unsigned int b = 0; b < 4; ++b)
+        {
+            size_t * count = counts[b];
+            if(count[(key_of((*from)[0]) >> (8*b)) & 0xff] == n)
+                continue;
+            size_t offset = 0;
+            for(unsigned int d = 0; d < 256; ++d)
+            {
+                const size_t c = count[d];
+                count[d] = offset;
+                offset += c;
+            }
+            for(const T & e : *from)
+                (*to)[count[(key_of(e) >> (8*b)) & 0xff]++] = e;
+            std::swap(from,to);
+        }
+        if(from != &v)
+            v.swap(buffer);
+    }
+
+    /* Stable sort of v by the K that key_of gives, radix sorted where K allows it */
+    template <typename K, bool RADIX = dbc_radix_key<K>::sortable>
+    struct dbc_sorter
+    {
+        template <typename T, typename KEY_OF>
+        static void sort(task_pool * pool, std::vector<T> & v, KEY_OF key_of)
+        {
+            parallel_merge_sort(pool,v,[&key_of](const T & l, const T & r)
+            {
+                return dbc_field_less_than<K>{}(key_of(l),key_of(r));
+            });
+        }
+    };
+    template <typename K>
+    struct dbc_sorter<K,true>
+    {
+        template <typename T, typename KEY_OF>
+        static void sort(task_pool *, std::vector<T> & v, KEY_OF key_of)
+        {
+            radix_sort(v,[&key_of](const T & e){ return dbc_radix_key<K>::key(key_of(e)); });
+        }
+    };
+
+    template <typename K>
+    struct dbc_sort_entry
+    {
+        K               key;
+        unsigned int    row;
+    };
+
+    /* Sorts rows by the values value_of(row) of a column of type T */
+    template <typename T>
+    struct dbc_column_sorter
+    {
+        template <typename VALUE_OF>
+        static void sort(task_pool * pool, VALUE_OF value_of, dbc_row_order & rows, std::shared_ptr<const dbc_collation_keys> &)
+        {
+            const unsigned int n = static_cast<unsigned int>(rows.size());
+            std::vector<dbc_sort_entry<T>> entries(n);
+            auto extract = [&entries,&value_of,&rows](unsigned int begin, unsigned int end)
+            {
+                for(unsigned int i = begin; i < end; ++i)
+                    entries[i] = dbc_sort_entry<T>{value_of(rows[i]),rows[i]};
+            };
+            if(pool)
+                pool->parallel_for(0,n,8192,extract);
+            else
+                extract(0,n);
+            dbc_sorter<T>::sort(pool,entries,[](const dbc_sort_entry<T> & e){ return e.key; });
+            for(unsigned int i = 0; i < n; ++i)
+                rows[i] = entries[i].row;
+        }
+    };
+    template <>
+    struct dbc_column_sorter<const char*>
+    {
+        template <typename VALUE_OF>
+        static void sort(task_pool * pool, VALUE_OF value_of, dbc_row_order & rows, std::shared_ptr<const dbc_collation_keys> & collation)
+        {
+            std::shared_ptr<dbc_collation_keys> keys = std::make_shared<dbc_collation_keys>();
+            keys->build(static_cast<unsigned int>(rows.size()),value_of);
+            parallel_merge_sort(pool,rows,[&keys](unsigned int l, unsigned int r)
+            {
+                return keys->compare(l,r) < 0;
+            });
+            collation = keys;
+        }
+    };
+
+    /* The rows of a table in order of column I, where the column is chosen at runtime. source gives the values of the
+     * rows, see dbc_columns.h. rows starts out in the order that rows with equal values keep. Sorting a column of
+     * strings gives their collation keys. */
+    template <typename RECORD, unsigned int I, unsigned int N>
+    struct dbc_column_sort
+    {
+        typedef typename std::tuple_element<I,RECORD>::type field_t;
+        template <typename SOURCE>
+        static void sort(unsigned int column, const SOURCE & source, dbc_row_order & rows, task_pool * pool,
+                         std::shared_ptr<const dbc_collation_keys> & collation)
+        {
+            if(column != I)
+            {
+                dbc_column_sort<RECORD,I+1,N>::sort(column,source,rows,pool,collation);
+                return;
+            }
+            dbc_column_sorter<field_t>::sort(pool,[&source](unsigned int row){ return source.template get<I>(row); },rows,collation);
+        }
+    };
+    template <typename RECORD, unsigned int N>
+    struct dbc_column_sort<RECORD,N,N>
+    {
+        template <typename SOURCE>
+        static void sort(unsigned int, const SOURCE &, dbc_row_order &, task_pool *, std::shared_ptr<const dbc_collation_keys> &){}
+    };
+} // dbc_impl
+
+#endif // DBC_SORT_H
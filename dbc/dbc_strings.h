@@ -0,0 +1,109 @@
+#ifndef DBC_STRINGS_H
+#define DBC_STRINGS_H
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <tuple>
+#include <cstring>
+#include <cstdint>
+
+/*
+ *  String blocks of projected tables
+ *
+ *  Strings of projected records point into an immutable string block, which is shared by reference counting between
+ *  everyone that uses it. A table can also compact its strings, i.e. build a string block of its own with only the
+ *  strings its records refer to, each stored once.
+ */
+
+namespace dbc_impl
+{
+    /* Copy size bytes of strings into a new block, shared by everyone holding the pointer */
+    inline std::shared_ptr<const char> make_string_block(const char * data, size_t size)
+    {
+        char * block = new char [size ? size : 1];
+        if(size)
+            memcpy(block,data,size);
+        return std::shared_ptr<const char>(block,std::default_delete<const char[]>());
+    }
+
+    /* Collects the strings referred to by the rows into a new, smaller string block. Each string is stored once. */
+    struct dbc_string_compactor
+    {
+        std::unordered_map<const char*,uint32_t>    offsets;
+        std::vector<char>                           block;
+
+        uint32_t intern(const char * s)
+        {
+            auto it = offsets.find(s);
+            if(it != offsets.end())
+                return (*it).second;
+            const uint32_t offset = static_cast<uint32_t>(block.size());
+            block.insert(block.end(),s,s + strlen(s) + 1);
+            offsets.insert(std::make_pair(s,offset));
+            return offset;
+        }
+        uint32_t offset_of(const char * s) const
+        {
+            return (*offsets.find(s)).second;
+        }
+    };
+
+    template <typename T>
+    struct dbc_string_field
+    {
+        static void intern(const T &, dbc_string_compactor &){}
+        static void rebase(T &, const dbc_string_compactor &, const char *){}
+    };
+    template <>
+    struct dbc_string_field<const char*>
+    {
+        static void intern(const char * s, dbc_string_compactor & strings)
+        {
+            strings.intern(s);
+        }
+        static void rebase(const char *& s, const dbc_string_compactor & strings, const char * block)
+        {
+            s = block + strings.offset_of(s);
+        }
+    };
+
+    /* Visits the string fields of a record */
+    template <typename RECORD, unsigned int I, unsigned int N>
+    struct dbc_record_strings
+    {
+        typedef typename std::tuple_element<I,RECORD>::type field_t;
+        static void intern(const RECORD & r, dbc_string_compactor & strings)
+        {
+            dbc_string_field<field_t>::intern(std::get<I>(r),strings);
+            dbc_record_strings<RECORD,I+1,N>::intern(r,strings);
+        }
+        static void rebase(RECORD & r, const dbc_string_compactor & strings, const char * block)
+        {
+            dbc_string_field<field_t>::rebase(std::get<I>(r),strings,block);
+            dbc_record_strings<RECORD,I+1,N>::rebase(r,strings,block);
+        }
+    };
+    template <typename RECORD, unsigned int N>
+    struct dbc_record_strings<RECORD,N,N>
+    {
+        static void intern(const RECORD &, dbc_string_compactor &){}
+        static void rebase(RECORD &, const dbc_string_compactor &, const char *){}
+    };
+
+    /* Move the strings records refer to into a new block of their own, and return it */
+    template <typename RECORD>
+    std::shared_ptr<const char> compact_strings(std::vector<RECORD> & records)
+    {
+        typedef dbc_record_strings<RECORD,0,std::tuple_size<RECORD>::value> strings_of;
+        dbc_string_compactor strings;
+        for(const RECORD & r : records)
+            strings_of::intern(r,strings);
+        std::shared_ptr<const char> block = make_string_block(strings.block.data(),strings.block.size());
+        for(RECORD & r : records)
+            strings_of::rebase(r,strings,block.get());
+        return block;
+    }
+} // dbc_impl
+
+#endif // DBC_STRINGS_H
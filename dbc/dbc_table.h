@@ -2,9 +2,24 @@
 #define DBC_TABLE_H
 
 #include <vector>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
 #include "dbc/dbc_files.h"
 #include "dbc/dbc_projection.h"
 #include "dbc/dbc.h"
+#include "dbc/dbc_cache.h"
+#include "dbc/dbc_sort.h"
+#include "dbc/dbc_search.h"
+#include "dbc/dbc_filter.h"
+#include "dbc/dbc_columns.h"
+#include "dbc/dbc_scan.h"
+#include "dbc/dbc_bitmap_index.h"
+#include "dbc/dbc_aggregate.h"
+#include "resource/task_pool.h"
 
 enum class dbc_table_state
 {
@@ -19,6 +34,13 @@ enum class dbc_table_error
     INVALID_SOURCE
 };
 
+enum class dbc_storage
+{
+    ROWS,               /* The records one after the other */
+    ROWS_AND_COLUMNS    /* The records, and a copy of them in one array per column, which scans, sorts, searches and
+                         * filters read. About twice the memory of ROWS. See dbc_columns.h. */
+};
+
 /*
  *  Given is a table T with n rows of records, where each record is uniquely identified by it's key fields
  *
@@ -26,11 +48,14 @@ enum class dbc_table_error
  *  So T[i] is said to be a row with index i. We now need a mapping k -> i where keys k are sorted for fast lookup (logn),
  *  Then T[k] is also allowed but implemented as T[f(k)] = T[i].
  *
- *  But now we also want this table to be sorted by any column, so we apply a sort on all rows and and get a list of
- *  keys in a new order and this order will be unordered with regards to the key, but ordered with regards to the column.
- *  This is a lookup si -> k where si is "sorted index".
+ *  But now we also want this table to be sorted by any column, so we apply a sort on all rows and get a list of
+ *  rows in a new order and this order will be unordered with regards to the key, but ordered with regards to the column.
+ *  This is a lookup si -> i where si is "sorted index".
  *
- *  The last thing we need is a lookup with k -> si
+ *  Sorting does not change the table itself. Each view of the table has its own lookup si -> i, so views of the same
+ *  table can be sorted differently. The lookup of a column is computed when some view is first sorted by it, on the
+ *  task_pool the table was loaded on, and then shared by every view sorted by that column. Sorting descending uses
+ *  the same lookup backwards.
  */
 
 template <typename K>
@@ -38,15 +63,253 @@ struct key_t
 {
     unsigned int    index;
     K               key;
-    unsigned int    sorted_index;
-    key_t(unsigned int idx, K k, unsigned int sorted_idx) : index(idx), key(k), sorted_index(sorted_idx) {}
+    key_t() : index(0), key() {}
+    key_t(unsigned int idx, K k) : index(idx), key(k) {}
+};
+
+/* The row of a key that is not in the table */
+constexpr unsigned int dbc_no_row = ~0u;
+
+enum class key_index_strategy
+{
+    DIRECT,     /* A flat array from key to row, for dense integer keys */
+    EYTZINGER   /* A search in the keys stored in breadth first order of a binary search tree */
+};
+
+/*
+ *  Finds the row of a key by a binary search over the keys in Eytzinger order: the root of the search tree at 1 and
+ *  the children of j at 2j and 2j+1. The first levels of the tree, visited by every search, share a few cache lines,
+ *  and the search descends without branching on the comparison.
+ */
+template <typename K>
+class eytzinger_key_search
+{
+private:
+    std::vector<K>              m_keys; /* m_keys[0] is unused */
+    std::vector<unsigned int>   m_rows;
+
+    void fill(const std::vector<key_t<K>> & sorted, unsigned int & i, unsigned int j)
+    {
+        if(j < m_keys.size())
+        {
+            fill(sorted,i,2*j);
+            m_keys[j] = sorted[i].key;
+            m_rows[j] = sorted[i].index;
+            ++i;
+            fill(sorted,i,2*j+1);
+        }
+    }
+public:
+    /* sorted must be ordered by key */
+    void build(const std::vector<key_t<K>> & sorted)
+    {
+        m_keys.assign(sorted.size()+1,K{});
+        m_rows.assign(sorted.size()+1,dbc_no_row);
+        unsigned int i = 0;
+        fill(sorted,i,1);
+    }
+
+    unsigned int find(const K & k) const
+    {
+        const unsigned int n = static_cast<unsigned int>(m_keys.size());
+        unsigned int j = 1;
+        while(j < n)
+        {
+            j = 2*j + static_cast<unsigned int>(dbc_impl::dbc_field_less_than<K>{}(m_keys[j],k));
+        }
+        /* Go back up past the right turns and the last left turn, to the smallest key not less than k */
+        while(j & 1)
+        {
+            j >>= 1;
+        }
+        j >>= 1;
+        return (j != 0 && !dbc_impl::dbc_field_less_than<K>{}(k,m_keys[j])) ? m_rows[j] : dbc_no_row;
+    }
+
+    void clear()
+    {
+        m_keys.clear();
+        m_rows.clear();
+    }
+};
+
+/* Finds the row of a key with a flat array indexed by key - min key */
+template <typename K>
+class direct_key_index
+{
+private:
+    K                           m_min;
+    std::vector<unsigned int>   m_rows;
+public:
+    direct_key_index() : m_min(), m_rows() {}
+
+    /* sorted must be ordered by key and not be empty */
+    void build(const std::vector<key_t<K>> & sorted)
+    {
+        m_min = sorted.front().key;
+        m_rows.assign(range(sorted),dbc_no_row);
+        for(const key_t<K> & k : sorted)
+        {
+            m_rows[static_cast<size_t>(offset(k.key,m_min))] = k.index;
+        }
+    }
+
+    unsigned int find(const K & k) const
+    {
+        if(k < m_min)
+            return dbc_no_row;
+        const uint64_t i = offset(k,m_min);
+        return i < m_rows.size() ? m_rows[static_cast<size_t>(i)] : dbc_no_row;
+    }
+
+    void clear()
+    {
+        m_rows.clear();
+    }
+
+    /* k - min, without overflowing K; k must not be less than min */
+    static uint64_t offset(const K & k, const K & min)
+    {
+        return static_cast<uint64_t>(static_cast<int64_t>(k) - static_cast<int64_t>(min));
+    }
+    static uint64_t range(const std::vector<key_t<K>> & sorted)
+    {
+        return sorted.empty() ? 0 : offset(sorted.back().key,sorted.front().key) + 1;
+    }
+    /* Worth it when at least a quarter of the keys in the range are used, or the range is small anyway */
+    static bool is_dense(const std::vector<key_t<K>> & sorted)
+    {
+        return !sorted.empty() && range(sorted) <= 4*uint64_t(sorted.size()) + 256;
+    }
+};
+
+/* Finds the row of a key, with the strategy that suits the keys best. Only integer keys can be indexed directly. */
+template <typename K, bool INTEGRAL = std::is_integral<K>::value>
+class dbc_key_index
+{
+private:
+    eytzinger_key_search<K>     m_search;
+public:
+    void build(const std::vector<key_t<K>> & sorted) { m_search.build(sorted); }
+    unsigned int find(const K & k) const { return m_search.find(k); }
+    void clear() { m_search.clear(); }
+    key_index_strategy strategy() const { return key_index_strategy::EYTZINGER; }
+};
+
+template <typename K>
+class dbc_key_index<K,true>
+{
+private:
+    key_index_strategy          m_strategy;
+    direct_key_index<K>         m_direct;
+    eytzinger_key_search<K>     m_search;
+public:
+    dbc_key_index() : m_strategy(key_index_strategy::EYTZINGER) {}
+
+    void build(const std::vector<key_t<K>> & sorted)
+    {
+        clear();
+        if(direct_key_index<K>::is_dense(sorted))
+        {
+            m_strategy = key_index_strategy::DIRECT;
+            m_direct.build(sorted);
+        }
+        else
+        {
+            m_strategy = key_index_strategy::EYTZINGER;
+            m_search.build(sorted);
+        }
+    }
+    unsigned int find(const K & k) const
+    {
+        return m_strategy == key_index_strategy::DIRECT ? m_direct.find(k) : m_search.find(k);
+    }
+    void clear()
+    {
+        m_direct.clear();
+        m_search.clear();
+    }
+    key_index_strategy strategy() const { return m_strategy; }
 };
 
+/* The keys of the rows published so far while a table is streamed (see dbc_table::set_streaming). Keys are only
+ * appended, so lookups can run while later rows are added. A key no less than the ascending keys before it is
+ * appended to those and found by bisection, any other key is put aside and found by comparing them one by one. The
+ * keys of a file sorted by key, but for a few, are nearly all bisected. */
 template <typename K>
-struct si_t
+class dbc_stream_key_index
 {
-    key_t<K> * key;
-    si_t(key_t<K> & k) : key(&k) {}
+private:
+    struct entry
+    {
+        K               key;
+        unsigned int    row;
+    };
+    std::vector<entry>          m_ascending;
+    std::vector<entry>          m_others;
+    std::atomic<unsigned int>   m_ascending_count;
+    std::atomic<unsigned int>   m_others_count;
+    unsigned int                m_size;     /* Rows appended so far, only read by the appending thread */
+
+public:
+    dbc_stream_key_index() : m_ascending(), m_others(), m_ascending_count(0), m_others_count(0), m_size(0) {}
+
+    /* Make room for n keys, so that appending never moves them */
+    void reset(unsigned int n)
+    {
+        m_ascending.assign(n,entry{K{},0});
+        m_others.assign(n,entry{K{},0});
+        m_ascending_count = 0;
+        m_others_count = 0;
+        m_size = 0;
+    }
+    /* Append the keys of the rows up to end. Lookups see them once the rows are published. */
+    template <typename KEY_OF>
+    void append(unsigned int end, KEY_OF key_of)
+    {
+        const dbc_impl::dbc_field_less_than<K> less{};
+        unsigned int ascending = m_ascending_count.load(std::memory_order_relaxed);
+        unsigned int others = m_others_count.load(std::memory_order_relaxed);
+        for(unsigned int row = m_size; row < end; ++row)
+        {
+            const K k = key_of(row);
+            if(ascending == 0 || !less(k,m_ascending[ascending-1].key))
+                m_ascending[ascending++] = entry{k,row};
+            else
+                m_others[others++] = entry{k,row};
+        }
+        m_size = end;
+        m_ascending_count.store(ascending,std::memory_order_release);
+        m_others_count.store(others,std::memory_order_release);
+    }
+    /* The row of k among the first published rows, or dbc_no_row */
+    unsigned int find(const K & k, unsigned int published) const
+    {
+        const dbc_impl::dbc_field_less_than<K> less{};
+        const unsigned int ascending = m_ascending_count.load(std::memory_order_acquire);
+        auto it = std::lower_bound(m_ascending.begin(),m_ascending.begin() + ascending,k,[&less](const entry & e, const K & key)
+        {
+            return less(e.key,key);
+        });
+        /* Rows are appended in order, the first of equal keys has the lowest row */
+        if(it != m_ascending.begin() + ascending && !less(k,it->key) && it->row < published)
+            return it->row;
+        const unsigned int others = m_others_count.load(std::memory_order_acquire);
+        for(unsigned int i = 0; i < others && m_others[i].row < published; ++i)
+        {
+            if(!less(k,m_others[i].key) && !less(m_others[i].key,k))
+                return m_others[i].row;
+        }
+        return dbc_no_row;
+    }
+    void clear()
+    {
+        m_ascending = std::vector<entry>{};
+        m_others = std::vector<entry>{};
+        m_ascending_count = 0;
+        m_others_count = 0;
+        m_size = 0;
+    }
 };
 
 template <typename K, typename RECORD>
@@ -55,24 +318,24 @@ struct key_index_lookup_table
 private:
     std::vector<RECORD>     data;
     std::vector<key_t<K>>   keys;
-    std::vector<si_t<K>>    sorted_keys;
+    /* The rows in order of their key, so that getting the row at a sorted index does not need a key lookup */
+    std::vector<unsigned int> key_rows;
 
-    unsigned int lookup_key_impl(const K & k, unsigned int l, unsigned int u) const
+    dbc_key_index<K>        index;
+
+    void index_sorted_keys()
     {
-        if(dbc_impl::dbc_field_less_than<K>{}(k,keys[(l+u)/2].key))
-        {
-            return lookup_key_impl(k,l,((l+u)/2));
-        }
-        else if(dbc_impl::dbc_field_less_than<K>{}(keys[(l+u)/2].key,k))
+        index.build(keys);
+        key_rows.resize(keys.size());
+        for(unsigned int i = 0; i < keys.size(); ++i)
         {
-            return lookup_key_impl(k,((l+u)/2)+1,u);
+            key_rows[i] = keys[i].index;
         }
-        return keys[(l+u)/2].index;
     }
 
     unsigned int lookup_key(const K & k) const
     {
-        return lookup_key_impl(k,0,keys.size()-1);
+        return index.find(k);
     }
 public:
 
@@ -80,55 +343,91 @@ public:
     void push_back(RECORD r, F f)
     {
         data.push_back(r);
-        keys.push_back(key_t<K>{data.size()-1,f(r),data.size()-1});
+        keys.push_back(key_t<K>{static_cast<unsigned int>(data.size()-1),f(r)});
+    }
+
+    /* Make room for n records, which are then filled in with set(). Different indices may be set concurrently. */
+    void resize(unsigned int n)
+    {
+        data.resize(n);
+        keys.clear();
+        keys.reserve(n);
+        for(unsigned int i = 0; i < n; ++i)
+        {
+            keys.push_back(key_t<K>{i,K{}});
+        }
+    }
+
+    template <typename F>
+    void set(unsigned int idx, RECORD r, F f)
+    {
+        keys[idx].key = f(r);
+        data[idx] = std::move(r);
     }
 
     /* Before using any other operation than push on this class, sort_keys() must be performed. */
     void sort_keys()
     {
-        sorted_keys.clear();
-        std::sort(keys.begin(),keys.end(),[](const key_t<K> & ls, const key_t<K> & rs)
-        {
-            return dbc_impl::dbc_field_less_than<K>{}(ls.key,rs.key);
-        });
+        dbc_impl::dbc_sorter<K>::sort(nullptr,keys,[](const key_t<K> & k){ return k.key; });
+        index_sorted_keys();
+    }
 
-        for(unsigned int i = 0; i < keys.size(); ++i)
+    /* Take over records whose key order is already known, instead of push_back() and sort_keys() */
+    template <typename F>
+    void assign(std::vector<RECORD> && records, const std::vector<unsigned int> & key_order, F f)
+    {
+        data = std::move(records);
+        keys.clear();
+        keys.reserve(key_order.size());
+        for(unsigned int i = 0; i < key_order.size(); ++i)
         {
-            sorted_keys.push_back(si_t<K>{keys[i]});
+            keys.push_back(key_t<K>{key_order[i],f(data[key_order[i]])});
         }
+        index_sorted_keys();
     }
 
-
-    void sort_by(bool (*cmp)(const RECORD&,const RECORD&))
+    /* Let f modify the records, then update the keys from them. Must be followed by sort_keys(). */
+    template <typename G, typename F>
+    void update_records(G g, F f)
     {
-        std::sort(sorted_keys.begin(),sorted_keys.end(), [=](const si_t<K> & L, const si_t<K> & R)
-        {
-            return cmp(data[(L.key)->index],data[(R.key)->index]);
-        });
-        for(unsigned int i = 0; i < sorted_keys.size(); ++i)
+        g(data);
+        for(key_t<K> & k : keys)
         {
-            (sorted_keys[i].key)->sorted_index = i;
+            k.key = f(data[k.index]);
         }
     }
 
+    /* The record indices, in order of their key */
+    const std::vector<unsigned int> & key_order() const { return key_rows; }
+    const std::vector<RECORD> & records() const { return data; }
+
+    /* The record at idx in order of the keys */
     const RECORD & at_index(unsigned int idx) const
     {
-        return data[lookup_key((*(sorted_keys[idx].key)).key)];
+        return data[key_rows[idx]];
+    }
+    const RECORD & at_row(unsigned int row) const
+    {
+        return data[row];
     }
+    /* key must be in the table */
     const RECORD & at_key(const K & key) const
     {
         return data[lookup_key(key)];
     }
+    /* The row of key, or dbc_no_row */
     unsigned int key_index(const K & key) const
     {
         return lookup_key(key);
     }
+    key_index_strategy key_strategy() const { return index.strategy(); }
 
     void clear()
     {
         data.clear();
         keys.clear();
-        sorted_keys.clear();
+        key_rows.clear();
+        index.clear();
     }
     unsigned int size() const { return data.size(); }
 };
@@ -136,28 +435,37 @@ public:
 struct empty_string
 {
     const char * string_block() { return nullptr; }
-    void reserve(unsigned int){}
-    void copy(const char *, unsigned int){}
+    void adopt(std::shared_ptr<const char>){}
+    template <typename VIEW>
+    void share(const VIEW &){}
+    template <typename RECORD>
+    void compact(std::vector<RECORD> &){}
+    void release(){}
 };
 
 struct string_wrapper
 {
-    char * m_data;
-    const char * string_block() { return m_data; }
-    void reserve(unsigned int n)
+    /* Immutable strings, shared with other tables of the same file or owned by a mapped cache file */
+    std::shared_ptr<const char> m_block;
+    const char * string_block() { return m_block.get(); }
+    void adopt(std::shared_ptr<const char> strings)
     {
-        m_data = new char[n];
+        m_block = std::move(strings);
     }
-    void copy(const char * begin, unsigned int count)
+    template <typename VIEW>
+    void share(const VIEW & view)
     {
-        memcpy(m_data,begin,count);
+        adopt(view.shared_string_block());
     }
-
-    string_wrapper() : m_data(nullptr) {}
-    ~string_wrapper()
+    /* Give the records a block of their own with only the strings they refer to */
+    template <typename RECORD>
+    void compact(std::vector<RECORD> & records)
+    {
+        adopt(dbc_impl::compact_strings(records));
+    }
+    void release()
     {
-        if(m_data)
-            delete [] m_data;
+        m_block.reset();
     }
 };
 
@@ -170,6 +478,7 @@ struct dbc_table_types
     typedef typename record_type::template projected_record<map> projected_record;
 
     enum { has_string = dbc_record<projected_record>::has_string };
+    enum { has_localized_string = dbc_record<projected_record>::has_localized_string };
 };
 
 
@@ -192,20 +501,472 @@ private:
 
     typedef map_index_type<PROJECTION::map_key> map_key_type;
 
-    unsigned int                                    m_order_by_field;
     key_index_lookup_table<map_key_type, record_t>  m_lookup_table;
 
-    void sort_by(unsigned int column)
+    enum { column_count = std::tuple_size<record_t>::value };
+
+    struct sort_request
+    {
+        std::weak_ptr<dbc_sort_slot>    slot;
+        bool                            descending;
+        unsigned int                    ticket;
+    };
+    struct column_order
+    {
+        std::shared_ptr<const dbc_row_order>    rows;       /* The ascending order, once computed */
+        std::shared_ptr<const dbc_collation_keys> collation;/* Of every row, for a column of strings */
+        bool                                    sorting;
+        std::vector<sort_request>               requests;   /* Waiting for the sort to finish */
+        column_order() : rows(), collation(), sorting(false), requests() {}
+    };
+
+    /* The orders of each column, computed when first asked for */
+    mutable std::mutex                  m_orders_mutex;
+    mutable std::vector<column_order>   m_column_orders;
+    task_pool *                         m_pool;
+    /* Sorts and index builds running on m_pool */
+    mutable task_group                  m_background;
+
+    /* The trigram indices of the searched columns, only accessed with std::atomic_load and std::atomic_store */
+    std::vector<bool>                                       m_search_columns;
+    std::vector<std::shared_ptr<const dbc_trigram_index>>   m_search_indices;
+    /* The prefix index of the completed column, accessed like the trigram indices */
+    unsigned int                                            m_prefix_column;
+    mutable std::shared_ptr<const dbc_prefix_index>         m_prefix_index;
+    /* The bitmap indices of the indexed columns, accessed like the trigram indices */
+    std::vector<bool>                                       m_bitmap_columns;
+    std::vector<std::shared_ptr<const dbc_bitmap_index>>    m_bitmap_indices;
+
+    /* Publish the order of column to slot, now if it is known and else once it is sorted */
+    void request_order(unsigned int column, bool ascending, const std::shared_ptr<dbc_sort_slot> & slot, unsigned int ticket) const
+    {
+        std::shared_ptr<const dbc_row_order> rows;
+        {
+            std::lock_guard<std::mutex> lock(m_orders_mutex);
+            m_column_orders.resize(column_count);
+            column_order & c = m_column_orders[column];
+            rows = c.rows;
+            if(!rows)
+            {
+                c.requests.push_back(sort_request{slot,!ascending,ticket});
+                if(c.sorting)
+                    return;
+                c.sorting = true;
+            }
+        }
+        if(rows)
+        {
+            slot->publish(rows,!ascending,ticket);
+            return;
+        }
+        if(m_pool)
+            m_pool->submit([this,column](){ sort_column(column); },&m_background);
+        else
+            sort_column(column);
+    }
+
+    void sort_column(unsigned int column) const
     {
-        m_lookup_table.sort_by([=](const record_t& L, const record_t& R)
+        /* Rows with equal values stay in order of their key */
+        std::shared_ptr<dbc_row_order> rows = std::make_shared<dbc_row_order>(m_lookup_table.key_order());
+        std::shared_ptr<const dbc_collation_keys> collation;
+        read_rows([this,column,&rows,&collation](const auto & source)
         {
-            return VIEW::record_type::compare_by_field(column,L,R);
+            dbc_impl::dbc_column_sort<record_t,0,column_count>::sort(column,source,*rows,m_pool,collation);
         });
+
+        std::vector<sort_request> requests;
+        {
+            std::lock_guard<std::mutex> lock(m_orders_mutex);
+            column_order & c = m_column_orders[column];
+            c.rows = rows;
+            c.collation = collation;
+            c.sorting = false;
+            requests.swap(c.requests);
+        }
+        for(const sort_request & r : requests)
+        {
+            if(std::shared_ptr<dbc_sort_slot> slot = r.slot.lock())
+                slot->publish(rows,r.descending,r.ticket);
+        }
+    }
+
+    void build_search_index(unsigned int column)
+    {
+        std::shared_ptr<dbc_trigram_index> index = std::make_shared<dbc_trigram_index>();
+        read_rows([this,column,&index](const auto & source)
+        {
+            index->build(m_lookup_table.size(),[&source,column](unsigned int row)
+            {
+                return dbc_impl::dbc_string_column<record_t,0,column_count>::get(column,source,row);
+            });
+        });
+        std::atomic_store(&m_search_indices[column],std::shared_ptr<const dbc_trigram_index>{index});
+    }
+
+    void build_prefix_index() const
+    {
+        std::shared_ptr<dbc_prefix_index> index = std::make_shared<dbc_prefix_index>();
+        const unsigned int column = m_prefix_column;
+        read_rows([this,column,&index](const auto & source)
+        {
+            index->build(m_lookup_table.size(),[&source,column](unsigned int row)
+            {
+                return dbc_impl::dbc_string_column<record_t,0,column_count>::get(column,source,row);
+            },m_pool);
+        });
+        std::atomic_store(&m_prefix_index,std::shared_ptr<const dbc_prefix_index>{index});
+    }
+
+    /* The prefix index, none until the build started by the load is published. It is not built again meanwhile, the
+     * caller does not wait for it. */
+    std::shared_ptr<const dbc_prefix_index> prefix_index() const
+    {
+        return std::atomic_load(&m_prefix_index);
+    }
+
+    void build_bitmap_index(unsigned int column)
+    {
+        std::shared_ptr<dbc_bitmap_index> index = std::make_shared<dbc_bitmap_index>();
+        read_rows([this,column,&index](const auto & source)
+        {
+            index->build(m_lookup_table.size(),[&source,column](unsigned int row)
+            {
+                return dbc_impl::dbc_int_column<record_t,0,column_count>::get(column,source,row);
+            });
+        });
+        std::atomic_store(&m_bitmap_indices[column],std::shared_ptr<const dbc_bitmap_index>{index});
+    }
+
+    /* The bitmap index of column, if it is built */
+    std::shared_ptr<const dbc_bitmap_index> bitmap_index(unsigned int column) const
+    {
+        if(!m_bitmap_columns[column])
+            return nullptr;
+        std::shared_ptr<const dbc_bitmap_index> index = std::atomic_load(&m_bitmap_indices[column]);
+        return index && index->count() == m_lookup_table.size() ? index : nullptr;
+    }
+
+    void build_indices()
+    {
+        if(m_prefix_column < column_count)
+        {
+            if(m_pool)
+                m_pool->submit([this](){ build_prefix_index(); },&m_background);
+            else
+                build_prefix_index();
+        }
+        for(unsigned int column = 0; column < column_count; ++column)
+        {
+            if(!m_search_columns[column])
+                continue;
+            if(m_pool)
+                m_pool->submit([this,column](){ build_search_index(column); },&m_background);
+            else
+                build_search_index(column);
+        }
+        for(unsigned int column = 0; column < column_count; ++column)
+        {
+            if(!m_bitmap_columns[column])
+                continue;
+            if(m_pool)
+                m_pool->submit([this,column](){ build_bitmap_index(column); },&m_background);
+            else
+                build_bitmap_index(column);
+        }
+    }
+
+    /* Call f(row) for the rows containing query in some searched column, a row may be given more than once */
+    template <typename F>
+    void search(const std::string & query, F f) const
+    {
+        const std::string folded = dbc_impl::fold_case(query.c_str());
+        const unsigned int n = m_lookup_table.size();
+        for(unsigned int column = 0; column < column_count; ++column)
+        {
+            if(!m_search_columns[column])
+                continue;
+            std::shared_ptr<const dbc_trigram_index> index = std::atomic_load(&m_search_indices[column]);
+            if(index && index->count() == n)
+            {
+                index->search(folded,f);
+                continue;
+            }
+            /* The index is not built yet */
+            read_rows([column,n,&folded,&f](const auto & source)
+            {
+                for(unsigned int row = 0; row < n; ++row)
+                {
+                    if(dbc_impl::contains_folded(dbc_impl::dbc_string_column<record_t,0,column_count>::get(column,source,row),folded))
+                        f(row);
+                }
+            });
+        }
+    }
+
+    /* Queue the rows within max_distance edits of query in some searched column to results, in batches ranked by
+     * distance as the workers of the pool scan them. Blocks until the rows are scanned or the search is cancelled. */
+    void fuzzy_scan(const std::string & query, unsigned int max_distance, dbc_fuzzy_results & results) const
+    {
+        const dbc_fuzzy_matcher matcher{query};
+        const unsigned int n = m_lookup_table.size();
+        std::vector<std::shared_ptr<const dbc_trigram_index>> indices(column_count);
+        for(unsigned int column = 0; column < column_count; ++column)
+        {
+            if(m_search_columns[column])
+                indices[column] = std::atomic_load(&m_search_indices[column]);
+        }
+        read_rows([&](const auto & source)
+        {
+            auto scan = [&](unsigned int begin, unsigned int end)
+            {
+                if(results.is_cancelled())
+                    return;
+                std::vector<dbc_fuzzy_match> batch;
+                for(unsigned int row = begin; row < end; ++row)
+                {
+                    unsigned int best = max_distance + 1;
+                    for(unsigned int column = 0; column < column_count && best; ++column)
+                    {
+                        if(!m_search_columns[column])
+                            continue;
+                        /* The folded strings of an index lie next to each other */
+                        const char * s = indices[column] && indices[column]->count() == n ?
+                                    indices[column]->folded_string(row) :
+                                    dbc_impl::dbc_string_column<record_t,0,column_count>::get(column,source,row);
+                        best = std::min(best,matcher.distance(s));
+                    }
+                    if(best <= max_distance)
+                        batch.push_back(dbc_fuzzy_match{row,best});
+                }
+                if(batch.empty())
+                    return;
+                std::stable_sort(batch.begin(),batch.end(),[](const dbc_fuzzy_match & l, const dbc_fuzzy_match & r)
+                {
+                    return l.distance < r.distance;
+                });
+                results.add(batch);
+            };
+            if(m_pool)
+                m_pool->parallel_for(0,n,2048,scan);
+            else
+                scan(0,n);
+        });
+    }
+
+    /* Scan in the background, see view::start_fuzzy_search */
+    std::shared_ptr<dbc_fuzzy_results> start_fuzzy_search(const std::string & query, unsigned int max_distance) const
+    {
+        std::shared_ptr<dbc_fuzzy_results> results = std::make_shared<dbc_fuzzy_results>();
+        if(!m_pool)
+        {
+            fuzzy_scan(query,max_distance,*results);
+            results->finish();
+            return results;
+        }
+        /* In the background group, so the records are not changed while they are scanned */
+        m_pool->submit([this,query,max_distance,results]()
+        {
+            fuzzy_scan(query,max_distance,*results);
+            results->finish();
+        },&m_background);
+        return results;
+    }
+
+    /* Sorts and index builds read the records, so they must be done before the records change */
+    void clear_column_orders()
+    {
+        if(m_pool)
+            m_pool->wait(m_background);
+        std::lock_guard<std::mutex> lock(m_orders_mutex);
+        m_column_orders.clear();
+        for(std::shared_ptr<const dbc_trigram_index> & index : m_search_indices)
+            std::atomic_store(&index,std::shared_ptr<const dbc_trigram_index>{});
+        std::atomic_store(&m_prefix_index,std::shared_ptr<const dbc_prefix_index>{});
+        for(std::shared_ptr<const dbc_bitmap_index> & index : m_bitmap_indices)
+            std::atomic_store(&index,std::shared_ptr<const dbc_bitmap_index>{});
     }
 
-    dbc_table_state             m_state;
+    /* Read by other threads, such as the GUI thread asking whether the table is loaded */
+    std::atomic<dbc_table_state> m_state;
     dbc_table_error             m_error;
     const VIEW *                m_view;
+    std::atomic<unsigned int>   m_rows_projected;
+
+    /* The number of rows projected by one task when loading on a task_pool */
+    enum { rows_per_task = 4096 };
+
+    /* Streamed loads publish the rows in batches, small at first so that the first rows show at once */
+    enum { first_batch_rows = 256, max_batch_rows = 65536 };
+    bool                                    m_streamed;
+    /* While streaming, views show the published rows in order of row, and find keys in m_stream_index */
+    std::atomic<bool>                       m_streaming;
+    /* The streamed loads started, a view shows rows in order of row until it takes over the order of the last one */
+    std::atomic<unsigned int>               m_streamed_loads;
+    std::atomic<unsigned int>               m_rows_published;
+    dbc_stream_key_index<map_key_type>      m_stream_index;
+
+    QString                     m_cache_directory;
+    /* A cache read by read_cache(), for the next load to take over */
+    struct cached_table
+    {
+        std::vector<record_t>       rows;
+        std::vector<unsigned int>   key_order;
+        std::shared_ptr<const char> strings;
+    };
+    std::unique_ptr<cached_table>   m_cached;
+    /* The last load built the table rather than taking over its cache, write_cache() saves it */
+    bool                        m_cache_outdated;
+    bool                        m_compact_strings;
+    dbc_locale                  m_locale;
+    dbc_storage                 m_storage;
+    dbc_columns<record_t>       m_columns;
+
+    /* Call f(source) with the source of the values of the rows (see dbc_columns.h), the columns if they are stored */
+    template <typename F>
+    void read_rows(F f) const
+    {
+        if(m_storage == dbc_storage::ROWS_AND_COLUMNS && m_columns.size() == m_lookup_table.size())
+            f(m_columns);
+        else
+            f(dbc_impl::dbc_row_source<record_t>{m_lookup_table.records()});
+    }
+
+    /* The values of column I in order of row: the stored column, else copied out of the records into buffer */
+    template <unsigned int I>
+    const typename std::tuple_element<I,record_t>::type * column_values(std::vector<typename std::tuple_element<I,record_t>::type> & buffer) const
+    {
+        const unsigned int n = m_lookup_table.size();
+        if(m_storage == dbc_storage::ROWS_AND_COLUMNS && m_columns.size() == n)
+            return m_columns.template column<I>().values.data();
+        buffer.resize(n);
+        const std::vector<record_t> & records = m_lookup_table.records();
+        for(unsigned int row = 0; row < n; ++row)
+            buffer[row] = std::get<I>(records[row]);
+        return buffer.data();
+    }
+
+    void build_columns()
+    {
+        if(m_storage == dbc_storage::ROWS_AND_COLUMNS)
+            m_columns.build(m_lookup_table.records(),this->string_block(),m_pool);
+    }
+
+    static map_key_type key_of(const record_t & t)
+    {
+        return std::get<static_cast<unsigned int>(PROJECTION::map_key)>(t);
+    }
+
+    std::string cache_path() const
+    {
+        return (m_cache_directory + QString{"/"} + QString{m_view->file_name()} + QString{"_"} +
+                QString::number(projection_hash(),16) + QString{".cache"}).toStdString();
+    }
+    uint64_t projection_hash() const
+    {
+        const uint64_t h = dbc_impl::dbc_projection_hash<record_type,map>::hash(static_cast<unsigned int>(PROJECTION::map_key));
+        /* Localized strings are projected in one locale only */
+        return dbc_table_types<VIEW,PROJECTION>::has_localized_string ? dbc_impl::hash_value(static_cast<uint64_t>(m_locale),h) : h;
+    }
+
+    /* Take over the cache read by read_cache(), if there is one */
+    bool take_cache()
+    {
+        if(!m_cached)
+            return false;
+        std::unique_ptr<cached_table> cached = std::move(m_cached);
+        this->adopt(cached->strings);
+        m_lookup_table.assign(std::move(cached->rows),cached->key_order,&key_of);
+        return true;
+    }
+
+    void save_cache() const
+    {
+        dbc_cache<record_t>::save(cache_path(),m_view->source_signature(),projection_hash(),
+                                  m_lookup_table.records(),m_lookup_table.key_order());
+    }
+
+    template <typename FOR_RANGES>
+    void load_impl(FOR_RANGES for_ranges)
+    {
+        if(m_state == dbc_table_state::CONFIGURED && m_error != dbc_table_error::INVALID_SOURCE)
+        {
+            clear_column_orders();
+            m_rows_published.store(0,std::memory_order_release);
+            m_cache_outdated = false;
+            if(take_cache())
+            {
+                m_rows_projected = m_lookup_table.size();
+                build_columns();
+                m_rows_published.store(m_lookup_table.size(),std::memory_order_release);
+                m_state = dbc_table_state::LOADED;
+                build_indices();
+                return;
+            }
+            /* Streamed records are read by views while loading, their strings can not be moved */
+            const bool compact = m_compact_strings && !m_streamed;
+            /* Compacted records are projected on the strings of the file, which stays loaded until the table is
+             * built, so the table never holds the whole string block */
+            if(!compact)
+                this->share(*m_view);
+            const char * string_block_begin = compact ? m_view->string_block() : this->string_block();
+            const unsigned int n = m_view->count();
+            m_rows_projected = 0;
+            m_lookup_table.resize(n);
+            if(m_streamed)
+            {
+                /* Views see no rows until the records are in place. The streaming is announced before the load is
+                 * counted, so a view seeing the new count also sees the streaming (see view::view). */
+                m_stream_index.reset(n);
+                m_streaming.store(true,std::memory_order_release);
+                m_streamed_loads.fetch_add(1,std::memory_order_acq_rel);
+            }
+            const dbc_locale locale = m_locale;
+            auto project = [this,string_block_begin,locale](unsigned int begin, unsigned int end)
+            {
+                for(unsigned int i = begin; i < end; ++i)
+                {
+                    m_lookup_table.set(i,dbc_impl::dbc_project_on_tuple<VIEW,record_type,map>::project(*m_view,i,string_block_begin,locale),
+                                       &key_of);
+                }
+                m_rows_projected += end - begin;
+            };
+            if(m_streamed)
+                stream(n,for_ranges,project);
+            else
+                for_ranges(n,project);
+            if(compact)
+            {
+                m_lookup_table.update_records([this](std::vector<record_t> & records){ this->compact(records); },&key_of);
+            }
+            m_lookup_table.sort_keys();
+            m_cache_outdated = !m_cache_directory.isEmpty() && dbc_cache<record_t>::is_supported;
+            build_columns();
+
+            /* All of them, a streamed load has published them all already */
+            m_rows_published.store(n,std::memory_order_release);
+            m_state = dbc_table_state::LOADED;
+            /* The views keep showing the rows in order of row, until they take over the order by key (see
+             * view::update_order) */
+            m_streaming.store(false,std::memory_order_release);
+            build_indices();
+        }
+    }
+
+    /* Project the rows in batches of growing size, and publish each batch to the views once it is projected */
+    template <typename FOR_RANGES, typename PROJECT>
+    void stream(unsigned int n, FOR_RANGES & for_ranges, const PROJECT & project)
+    {
+        unsigned int batch = first_batch_rows;
+        for(unsigned int begin = 0; begin < n; batch = std::min<unsigned int>(2*batch,max_batch_rows))
+        {
+            const unsigned int end = std::min(n,begin + batch);
+            for_ranges(end - begin,[begin,&project](unsigned int b, unsigned int e){ project(begin + b,begin + e); });
+            m_stream_index.append(end,[this](unsigned int row){ return key_of(m_lookup_table.at_row(row)); });
+            m_rows_published.store(end,std::memory_order_release);
+            begin = end;
+        }
+    }
 
 public:
 
@@ -213,9 +974,270 @@ public:
     {
         m_state = dbc_table_state::BEGIN;
         m_error = dbc_table_error::NO_ERROR;
-        m_order_by_field = static_cast<unsigned int>(PROJECTION::map_key);
+        m_rows_projected = 0;
+        m_streamed = false;
+        m_streaming = false;
+        m_streamed_loads = 0;
+        m_rows_published = 0;
+        m_pool = nullptr;
+        m_cache_outdated = false;
+        /* The string block of a file with localized strings holds every locale, but only one of them is projected */
+        m_compact_strings = dbc_table_types<VIEW,PROJECTION>::has_localized_string;
+        m_locale = dbc_locale::enUS;
+        m_storage = dbc_storage::ROWS;
+        m_search_columns.assign(column_count,false);
+        m_search_indices.resize(column_count);
+        m_bitmap_columns.assign(column_count,false);
+        m_bitmap_indices.resize(column_count);
+        m_prefix_column = column_count;
+    }
+    ~dbc_table()
+    {
+        clear_column_orders();
+    }
+
+    /* Keep a cache of the built table in dir, so the next load does not need to project and sort. See read_cache()
+     * and write_cache(). Records with values wider than 32 bits are not cached (see dbc_cache::is_supported). */
+    void set_cache_directory(const QString & dir)
+    {
+        m_cache_directory = dir;
+    }
+
+    /* Keep only the strings this table refers to, instead of sharing the whole string block of the file with other
+     * tables. Worth it when the projection uses a small part of the strings of a big file. This is the default for
+     * projections of localized strings. */
+    void set_string_compaction(bool compact)
+    {
+        m_compact_strings = compact;
+    }
+
+    /* Make column searchable by view::search(), with an index built in the background once the table is loaded.
+     * Only columns of strings can be searched. Must be called before loading. */
+    void enable_search(unsigned int column)
+    {
+        if(dbc_impl::dbc_string_column<record_t,0,column_count>::is_string(column))
+            m_search_columns[column] = true;
+    }
+
+    /* Index the rows of each value of column in a bitmap index (see dbc_bitmap_index.h), built in the background once
+     * the table is loaded. Filters then find the rows of values without testing rows. Meant for columns of few
+     * distinct values, only columns of integers can be indexed. Must be called before loading. */
+    void enable_bitmap_index(unsigned int column)
+    {
+        if(dbc_impl::dbc_int_column<record_t,0,column_count>::is_int(column))
+            m_bitmap_columns[column] = true;
+    }
+
+    /* Make column the one completed by view::complete(), with an index built in the background once the table is
+     * loaded. Only a column of strings can be completed. Must be called before loading. */
+    void enable_completion(unsigned int column)
+    {
+        if(dbc_impl::dbc_string_column<record_t,0,column_count>::is_string(column))
+            m_prefix_column = column;
+    }
+
+    /* Completes a prefix of the completed column (see enable_completion) while it is typed. The records starting with
+     * the prefix are listed in order of their string. */
+    class completion
+    {
+    private:
+        const dbc_table &                       m_table;
+        std::shared_ptr<const dbc_prefix_index> m_index;
+        /* The range of every prefix typed so far, of the empty prefix first */
+        std::vector<dbc_prefix_range>           m_ranges;
+        std::string                             m_prefix;
+    public:
+        completion(const dbc_table & t, std::shared_ptr<const dbc_prefix_index> index) :
+            m_table(t), m_index(std::move(index)), m_ranges(), m_prefix()
+        {
+            m_ranges.push_back(m_index ? m_index->all() : dbc_prefix_range{0,0,0});
+        }
+
+        /* Narrow the records down to those going on with c, in O(log count()) */
+        void extend(char c)
+        {
+            m_ranges.push_back(m_index ? m_index->extend(m_ranges.back(),c) : m_ranges.back());
+            m_prefix.push_back(c);
+        }
+        void extend(const std::string & s)
+        {
+            for(char c : s)
+                extend(c);
+        }
+        /* Take back the last character, in O(1) */
+        void retract()
+        {
+            if(m_ranges.size() > 1)
+            {
+                m_ranges.pop_back();
+                m_prefix.pop_back();
+            }
+        }
+
+        /* The index was built when the completion started, else it completes to no records */
+        bool is_ready() const { return m_index != nullptr; }
+        const std::string & prefix() const { return m_prefix; }
+        unsigned int count() const { return m_ranges.back().size(); }
+        unsigned int row_at(unsigned int idx) const { return m_index->row(m_ranges.back().begin + idx); }
+        const record_t & record_at(unsigned int idx) const { return m_table.m_lookup_table.at_row(row_at(idx)); }
+    };
+
+    /* The records of a table passing some predicates on their columns, see dbc_filter.h. A view shows only the
+     * records passing a filter once it is filtered by it (see view::filter_by). */
+    class filter
+    {
+    private:
+        template <unsigned int I>
+        using field_t = typename std::tuple_element<I,record_t>::type;
+
+        const dbc_table &   m_table;
+        dbc_row_bitmap      m_rows;
+
+        /* Keep the rows of any of values (with any bit of values[0] if bits) by the bitmap index of column, if it is
+         * built. Columns of other types than int have none. */
+        template <typename T>
+        bool refine_by_index(unsigned int, const std::vector<T> &, bool) { return false; }
+        bool refine_by_index(unsigned int column, const std::vector<int> & values, bool bits)
+        {
+            std::shared_ptr<const dbc_bitmap_index> index = m_table.bitmap_index(column);
+            if(!index)
+                return false;
+            dbc_row_bitmap matches(m_rows.size(),false);
+            if(bits)
+                index->add_rows_with_any(values[0],matches);
+            else
+                index->add_rows_of(values,matches);
+            m_rows &= matches;
+            return true;
+        }
+    public:
+        /* Every record of t passes */
+        explicit filter(const dbc_table & t) : m_table(t), m_rows(t.m_lookup_table.size(),true) {}
+
+        /* Keep the records for which p(value of column I) is true. Only the records that pass so far are tested. */
+        template <unsigned int I, typename P>
+        filter & where(P p)
+        {
+            m_table.read_rows([this,&p](const auto & source)
+            {
+                m_rows.retain([&source,&p](unsigned int row){ return p(source.template get<I>(row)); });
+            });
+            return *this;
+        }
+        /* equal_to, in and any_bits use the bitmap index of column I if it is built */
+        template <unsigned int I>
+        filter & equal_to(const field_t<I> & value)
+        {
+            return refine_by_index(I,std::vector<field_t<I>>{value},false) ? *this : where<I>(dbc_equal_to<field_t<I>>{value});
+        }
+        template <unsigned int I>
+        filter & in(std::vector<field_t<I>> values)
+        {
+            if(refine_by_index(I,values,false))
+                return *this;
+            std::sort(values.begin(),values.end(),dbc_impl::dbc_field_less_than<field_t<I>>{});
+            return where<I>([&values](const field_t<I> & v)
+            {
+                return std::binary_search(values.begin(),values.end(),v,dbc_impl::dbc_field_less_than<field_t<I>>{});
+            });
+        }
+        template <unsigned int I>
+        filter & any_bits(int mask)
+        {
+            return refine_by_index(I,std::vector<int>{mask},true) ? *this : where<I>([mask](int v){ return (v & mask) != 0; });
+        }
+        template <unsigned int I>
+        filter & less_than(const field_t<I> & value) { return where<I>(dbc_less_than<field_t<I>>{value}); }
+        template <unsigned int I>
+        filter & greater_than(const field_t<I> & value) { return where<I>(dbc_greater_than<field_t<I>>{value}); }
+        template <unsigned int I>
+        filter & in_range(const field_t<I> & low, const field_t<I> & high) { return where<I>(dbc_in_range<field_t<I>>{low,high}); }
+        template <unsigned int I>
+        filter & contains(const std::string & substring) { return where<I>(dbc_contains{substring}); }
+
+        /* Keep the records whose value of column I passes op against a (and b for IN_RANGE), see dbc_scan.h. Unlike
+         * where(), all records are tested, with vector instructions on the stored column. Faster unless only a few
+         * records are left. Columns of integers and floats only. */
+        template <unsigned int I>
+        filter & scan(dbc_scan_op op, field_t<I> a, field_t<I> b = field_t<I>{})
+        {
+            const unsigned int n = m_rows.size();
+            dbc_row_bitmap passing(n,false);
+            std::vector<field_t<I>> buffer;
+            dbc_scan(m_table.template column_values<I>(buffer),n,op,a,b,passing.words());
+            m_rows &= passing;
+            return *this;
+        }
+
+        /* The records passing both filters, or either of them. Both must be filters of the same table. */
+        filter & operator &= (const filter & f) { m_rows &= f.m_rows; return *this; }
+        filter & operator |= (const filter & f) { m_rows |= f.m_rows; return *this; }
+        friend filter operator & (filter l, const filter & r) { return l &= r; }
+        friend filter operator | (filter l, const filter & r) { return l |= r; }
+
+        bool passes(unsigned int row) const { return m_rows.test(row); }
+        unsigned int count() const { return m_rows.count(); }
+        const dbc_row_bitmap & rows() const { return m_rows; }
+    };
+
+    /* Group the records (only those passing f if given) by their value of the int column KEY, and aggregate their values
+     * of the int or float column VALUE in each group, see dbc_aggregate.h. Grouping by KEY alone counts the records of
+     * each key. Parts of the records are aggregated on the table's pool. */
+    template <unsigned int KEY, unsigned int VALUE = KEY>
+    dbc_group_by<typename std::tuple_element<VALUE,record_t>::type> group_by(const filter * f = nullptr) const
+    {
+        static_assert(std::is_same<typename std::tuple_element<KEY,record_t>::type,int>::value,"Records can only be grouped by an int column");
+        std::vector<int> key_buffer;
+        std::vector<typename std::tuple_element<VALUE,record_t>::type> value_buffer;
+        const int * keys = column_values<KEY>(key_buffer);
+        const auto * values = column_values<VALUE>(value_buffer);
+        dbc_group_by<typename std::tuple_element<VALUE,record_t>::type> groups;
+        groups.build(keys,values,m_lookup_table.size(),f ? &f->rows() : nullptr,m_pool);
+        return groups;
+    }
+
+    /* Publish the records in batches while loading, instead of all at once when loaded. Until the table is loaded its
+     * views show the published records in order of row (see rows_published), and can not be sorted, filtered or
+     * searched. Once it is loaded they keep that order until they take over the order by key with update_order(),
+     * which has_new_order() tells. The strings of a streamed table are not compacted, it keeps the whole string
+     * block of the file (see set_string_compaction). Must be set before loading. */
+    void set_streaming(bool streamed)
+    {
+        m_streamed = streamed;
+    }
+    /* The table is being streamed, and not yet loaded */
+    bool is_streaming() const { return m_streaming.load(std::memory_order_acquire); }
+    /* The number of records views can show: those published so far while streaming, else all once loaded */
+    unsigned int rows_published() const
+    {
+        return m_rows_published.load(std::memory_order_acquire);
+    }
+
+    /* How the records are stored, must be set before loading. The columns are kept in addition to the records, which
+     * views return by reference: worth their memory for big tables that are scanned, sorted or searched often. */
+    void set_storage(dbc_storage storage)
+    {
+        m_storage = storage;
+    }
+    /* The columns of the records, if they are stored by column too. They can be read once the table is loaded. */
+    const dbc_columns<record_t> & columns() const { return m_columns; }
+
+    /* The records by row, the rows that views, indices and joins (see dbc_join.h) refer to. They can be read once the
+     * table is loaded. */
+    unsigned int row_count() const { return m_lookup_table.size(); }
+    const record_t & record_of_row(unsigned int row) const { return m_lookup_table.at_row(row); }
+    /* The row of key, or dbc_no_row */
+    unsigned int row_of_key(const map_key_type & key) const
+    {
+        return is_streaming() ? m_stream_index.find(key,rows_published()) : m_lookup_table.key_index(key);
+    }
+
+    /* The locale of projected localized strings, those that are empty in locale are projected in enUS.
+     * Must be set before loading. */
+    void set_locale(dbc_locale locale)
+    {
+        m_locale = locale;
     }
-    ~dbc_table(){}
 
     void configure(const VIEW & view)
     {
@@ -225,29 +1247,49 @@ public:
             m_error = dbc_table_error::INVALID_SOURCE;
     }
 
+    /* Read the cache of the table, if there is a valid one, for the next load to take over instead of projecting the
+     * records. Together with write_cache() these are the disk accesses of a load, which resource_graph::add_derived
+     * runs on its I/O lane. Must be called after configure(). */
+    void read_cache()
+    {
+        m_cached.reset();
+        if(m_state != dbc_table_state::CONFIGURED || m_error == dbc_table_error::INVALID_SOURCE || m_cache_directory.isEmpty())
+            return;
+        std::unique_ptr<cached_table> cached{new cached_table};
+        if(dbc_cache<record_t>::load(cache_path(),m_view->source_signature(),projection_hash(),cached->rows,cached->key_order,cached->strings))
+            m_cached = std::move(cached);
+    }
+    /* Save the table to its cache, if the last load built it rather than taking over the cache */
+    void write_cache()
+    {
+        if(!m_cache_outdated || m_state != dbc_table_state::LOADED)
+            return;
+        m_cache_outdated = false;
+        save_cache();
+    }
+
+    /* Project all records on the calling thread, reading and writing the cache there too */
     void load()
     {
-        if(m_state == dbc_table_state::CONFIGURED && m_error != dbc_table_error::INVALID_SOURCE)
+        read_cache();
+        load_impl([](unsigned int n, const std::function<void(unsigned int,unsigned int)> & project)
         {
-            if(dbc_table_types<VIEW,PROJECTION>::has_string)
-            {
-                this->reserve(m_view->string_block_size());
-                this->copy(m_view->string_block(),m_view->string_block_size());
-            }
-            const char * string_block_begin = this->string_block();
-            for(unsigned int i = 0; i < m_view->count(); ++i)
-            {
-                auto key_data_f = [](const record_t & t) -> map_key_type
-                {
-                    return std::get<static_cast<unsigned int>(PROJECTION::map_key)>(t);
-                };
-                m_lookup_table.push_back(dbc_impl::dbc_project_on_tuple<VIEW,record_type,map>::project(*m_view,i,string_block_begin),
-                                         key_data_f);
-            }
-            m_lookup_table.sort_keys();
+            project(0,n);
+        });
+        write_cache();
+    }
 
-            m_state = dbc_table_state::LOADED;
-        }
+    /* Project the records in ranges of rows, as tasks on pool that idle workers can steal. Views of the table are
+     * sorted on pool too, pool must outlive the table. The cache is neither read nor written, the caller does that
+     * on its own thread (see read_cache). */
+    void load(task_pool & pool)
+    {
+        clear_column_orders();
+        m_pool = &pool;
+        load_impl([&pool](unsigned int n, const std::function<void(unsigned int,unsigned int)> & project)
+        {
+            pool.parallel_for(0,n,rows_per_task,project);
+        });
     }
 
     bool is_valid() const { return (m_state == dbc_table_state::CONFIGURED) ? m_view.is_valid() : true; }
@@ -268,7 +1310,9 @@ public:
 
     float progress_value() const
     {
-        return (m_state == dbc_table_state::CONFIGURED ? 100.0f*float(m_lookup_table.size())/float(m_view->count()) : 0.0f);
+        if(m_state == dbc_table_state::LOADED)
+            return 100.0f;
+        return (m_state == dbc_table_state::CONFIGURED && m_view->is_valid() && m_view->count() ? 100.0f*float(m_rows_projected)/float(m_view->count()) : 0.0f);
     }
 
     bool is_completed() const { return m_state == dbc_table_state::LOADED; }
@@ -278,35 +1322,282 @@ public:
     {
         if(m_state == dbc_table_state::LOADED)
         {
-            m_state = dbc_state::CONFIGURED;
+            m_state = dbc_table_state::CONFIGURED;
+            /* The background tasks read the records */
+            clear_column_orders();
             m_lookup_table.clear();
+            m_stream_index.clear();
+            m_columns.clear();
+            this->release();
         }
-        m_error = dbc_error::NO_ERROR;
-        m_order_by_field = static_cast<unsigned int>(PROJECTION::map_key);
+        m_error = dbc_table_error::NO_ERROR;
     }
 
     struct view
     {
     private:
-        const dbc_table & m_table;
+        const dbc_table &                       m_table;
+        std::shared_ptr<dbc_sort_slot>          m_slot;
+        /* The order taken over from m_slot. Its rows are si -> i of this view, or none when in order of the key. */
+        std::shared_ptr<const dbc_sorted_order> m_sorted;
+        const dbc_row_order *                   m_order;
+        bool                                    m_descending;
+        /* The rows passing the filter of this view, if it is filtered, in order of this view */
+        std::shared_ptr<const dbc_row_bitmap>   m_filter;
+        std::vector<unsigned int>               m_visible;
+        /* Row -> index in this view, built when first needed after the order or the filter changed */
+        mutable std::vector<unsigned int>       m_index_of_row;
+
+        /* The last streamed load of the table this view took over the order of */
+        unsigned int                            m_ordered_load;
+
+        /* The streamed load to take over the order of, or one before the current load while it is streaming. The
+         * count is read first: the streaming is announced before a load is counted. */
+        static unsigned int load_to_order(const dbc_table & t)
+        {
+            const unsigned int loads = t.m_streamed_loads.load(std::memory_order_acquire);
+            return t.is_streaming() ? loads - 1 : loads;
+        }
+
+        /* Rows of a streamed table are shown in order of row, until this view takes over its order once it is loaded */
+        bool in_row_order() const
+        {
+            return m_ordered_load != m_table.m_streamed_loads.load(std::memory_order_acquire);
+        }
+        /* The row at idx when not filtered */
+        inline unsigned int order_row_at(unsigned int idx) const
+        {
+            if(in_row_order())
+                return idx;
+            const unsigned int n = m_table.m_lookup_table.size();
+            if(m_descending)
+                idx = n - 1 - idx;
+            /* An order of an earlier load of the table is not used */
+            if(m_order && m_order->size() == n)
+                return (*m_order)[idx];
+            return m_table.m_lookup_table.key_order()[idx];
+        }
+        void update_visible()
+        {
+            m_visible.clear();
+            m_index_of_row.clear();
+            if(!m_filter)
+                return;
+            const unsigned int n = m_table.m_lookup_table.size();
+            /* A filter of an earlier load of the table is dropped */
+            if(m_filter->size() != n)
+            {
+                m_filter.reset();
+                return;
+            }
+            for(unsigned int idx = 0; idx < n; ++idx)
+            {
+                const unsigned int row = order_row_at(idx);
+                if(m_filter->test(row))
+                    m_visible.push_back(row);
+            }
+        }
+        /* Row -> index in this view, dbc_no_row for the records this view does not show. Not while streaming. */
+        const std::vector<unsigned int> & index_of_rows() const
+        {
+            /* An index of an earlier load of the table is rebuilt */
+            if(m_index_of_row.size() != m_table.m_lookup_table.size())
+            {
+                m_index_of_row.assign(m_table.m_lookup_table.size(),dbc_no_row);
+                const unsigned int n = count();
+                for(unsigned int idx = 0; idx < n; ++idx)
+                    m_index_of_row[row_at(idx)] = idx;
+            }
+            return m_index_of_row;
+        }
+        /* The index in this view of row, or dbc_no_row */
+        unsigned int index_of_row(unsigned int row) const
+        {
+            if(in_row_order())
+                return row < count() ? row : dbc_no_row;
+            const std::vector<unsigned int> & index_of_row = index_of_rows();
+            return row < index_of_row.size() ? index_of_row[row] : dbc_no_row;
+        }
     public:
         typedef dbc_table::record_t record_t;
-        view(const dbc_table & t) : m_table(t) {}
+        view(const dbc_table & t) :
+            m_table(t), m_slot(std::make_shared<dbc_sort_slot>()), m_sorted(), m_order(nullptr), m_descending(false),
+            m_filter(), m_visible(), m_index_of_row(), m_ordered_load(load_to_order(t))
+        {}
+        /* A copy has the order of v, but not a sort of v that is not taken over yet */
+        view(const view & v) :
+            m_table(v.m_table), m_slot(std::make_shared<dbc_sort_slot>()), m_sorted(v.m_sorted), m_order(v.m_order),
+            m_descending(v.m_descending), m_filter(v.m_filter), m_visible(v.m_visible), m_index_of_row(),
+            m_ordered_load(v.m_ordered_load)
+        {
+            if(m_sorted)
+            {
+                m_slot->ticket = m_sorted->ticket;
+                m_slot->published = m_sorted;
+            }
+        }
 
+        /* The row of the record at idx, see dbc_table::record_of_row */
+        inline unsigned int row_at(unsigned int idx) const
+        {
+            return m_filter && !in_row_order() ? m_visible[idx] : order_row_at(idx);
+        }
         inline const record_t& record_at(unsigned int idx) const
         {
-            return m_table.m_lookup_table.at_index(idx);
+            return m_table.m_lookup_table.at_row(row_at(idx));
+        }
+
+        /* Order this view by column. Other views of the same table keep their own order.
+         * If the column is not sorted yet it is sorted in the background, and this view keeps its current order until
+         * update_order() finds the new one. */
+        void sort_by(unsigned int column, bool ascending = true)
+        {
+            m_table.request_order(column,ascending,m_slot,++m_slot->ticket);
+            update_order();
+        }
+        void sort_by_key(bool ascending = true)
+        {
+            m_slot->publish(nullptr,!ascending,++m_slot->ticket);
+            update_order();
+        }
+        /* The last sort_by is done, or a streamed table is loaded, but its order is not taken over yet */
+        bool has_new_order() const
+        {
+            if(in_row_order() && !m_table.is_streaming())
+                return true;
+            std::shared_ptr<const dbc_sorted_order> sorted = std::atomic_load(&m_slot->published);
+            return sorted && sorted != m_sorted && sorted->ticket == m_slot->ticket;
+        }
+        /* Take over the order of the last sort_by, if it is done, or the order by key of a streamed table once it is
+         * loaded. True if the order of the view changed. A model on this view must be told, see
+         * dbc_item_model::reorder. */
+        bool update_order()
+        {
+            bool changed = false;
+            if(in_row_order())
+            {
+                /* Read in the order of load_to_order, so the order of a load that is still streaming is not taken */
+                const unsigned int loads = m_table.m_streamed_loads.load(std::memory_order_acquire);
+                if(m_table.is_streaming())
+                    return false;
+                m_ordered_load = loads;
+                changed = true;
+            }
+            std::shared_ptr<const dbc_sorted_order> sorted = std::atomic_load(&m_slot->published);
+            if(!sorted || sorted == m_sorted || sorted->ticket != m_slot->ticket)
+            {
+                if(changed)
+                    update_visible();
+                return changed;
+            }
+            m_sorted = sorted;
+            m_order = sorted->rows.get();
+            m_descending = sorted->descending;
+            update_visible();
+            return true;
         }
+        /* A sort_by, or the order of a streamed table, is not yet taken over */
+        bool is_sorting() const
+        {
+            return in_row_order() || m_slot->ticket != (m_sorted ? m_sorted->ticket : 0);
+        }
+        /* Show only the records passing f, in the order of this view. f can be refined and this view filtered by it
+         * again, the records are not tested again for that. A model on this view must be reset meanwhile. */
+        void filter_by(const filter & f)
+        {
+            m_filter = std::make_shared<dbc_row_bitmap>(f.rows());
+            update_visible();
+        }
+        void clear_filter()
+        {
+            m_filter.reset();
+            m_visible.clear();
+            m_index_of_row.clear();
+        }
+        bool is_filtered() const { return m_filter != nullptr; }
+
+        /* The indices in this view of the records containing substring in a searched column (see
+         * dbc_table::enable_search), in order of this view. ASCII letters match in either case. */
+        std::vector<unsigned int> search(const std::string & substring) const
+        {
+            /* Only the matches are mapped to this view, the other records are not visited */
+            std::vector<unsigned int> indices;
+            m_table.search(substring,[this,&indices](unsigned int row)
+            {
+                const unsigned int idx = index_of_row(row);
+                if(idx != dbc_no_row)
+                    indices.push_back(idx);
+            });
+            std::sort(indices.begin(),indices.end());
+            indices.erase(std::unique(indices.begin(),indices.end()),indices.end());
+            return indices;
+        }
+
+        /* Start searching the records within max_distance edits of query in a searched column (see
+         * dbc_table::enable_search), in the background on the table's pool. The matches are taken with
+         * take_fuzzy_matches() on the calling thread while the workers scan, for instance from a timer of the GUI, so
+         * a list fills as they are found. Cancel the results to stop the search. */
+        std::shared_ptr<dbc_fuzzy_results> start_fuzzy_search(const std::string & query, unsigned int max_distance) const
+        {
+            return m_table.start_fuzzy_search(query,max_distance);
+        }
+        /* The matches of results found since the last take, as their indices in this view and their distance, each
+         * batch ranked by distance. The records this view does not show are left out. */
+        std::vector<dbc_fuzzy_match> take_fuzzy_matches(dbc_fuzzy_results & results) const
+        {
+            std::vector<dbc_fuzzy_match> matches = results.take();
+            size_t shown = 0;
+            for(const dbc_fuzzy_match & match : matches)
+            {
+                const unsigned int idx = index_of_row(match.row);
+                if(idx != dbc_no_row)
+                    matches[shown++] = dbc_fuzzy_match{idx,match.distance};
+            }
+            matches.resize(shown);
+            return matches;
+        }
+        /* The indices in this view of the records within max_distance edits of query, the closest first and else in
+         * order of this view. Blocks until all records are scanned. */
+        std::vector<unsigned int> fuzzy_search(const std::string & query, unsigned int max_distance) const
+        {
+            dbc_fuzzy_results results;
+            m_table.fuzzy_scan(query,max_distance,results);
+            std::vector<dbc_fuzzy_match> matches = take_fuzzy_matches(results);
+            std::sort(matches.begin(),matches.end(),[](const dbc_fuzzy_match & l, const dbc_fuzzy_match & r)
+            {
+                return l.distance != r.distance ? l.distance < r.distance : l.row < r.row;
+            });
+            std::vector<unsigned int> indices(matches.size());
+            for(size_t i = 0; i < matches.size(); ++i)
+                indices[i] = matches[i].row;
+            return indices;
+        }
+
+        /* Start completing prefix in the completed column of the table. Until the index is built in the background
+         * the completion is empty (see completion::is_ready), and must be started again once it is. */
+        completion complete(const std::string & prefix = std::string{}) const
+        {
+            completion c{m_table,m_table.prefix_index()};
+            c.extend(prefix);
+            return c;
+        }
+
+        /* The row of key, or dbc_no_row if there is no such key */
         inline unsigned int key_index(const map_key_type& key) const
         {
-            return m_table.m_lookup_table.key_index(key);
+            return m_table.row_of_key(key);
         }
 
         bool is_valid() const { return m_table.is_valid(); }
         std::string error_msg() const { return m_table.error_msg(); }
         bool correct_error() const { return m_table.correct_error(); }
         float progress_value() const { return m_table.progress_value(); }
-        unsigned int count() const { return m_table.m_lookup_table.size(); }
+        unsigned int count() const
+        {
+            if(in_row_order())
+                return m_table.rows_published();
+            return m_filter ? static_cast<unsigned int>(m_visible.size()) : m_table.m_lookup_table.size();
+        }
     };
 
     /* Get the view */
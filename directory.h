@@ -44,9 +44,13 @@ class dbc_directory
 {
 private:
     directory m_directory;
+    directory m_cache_directory;
+    QString   m_locale;
 public:
     dbc_directory(const configuration & cfg) :
-        m_directory(cfg.get_string("DBC.Directory"))
+        m_directory(cfg.get_string("DBC.Directory")),
+        m_cache_directory(cfg.get_string("DBC.Cache")),
+        m_locale(cfg.get_string("DBC.Locale"))
     {
 
     }
@@ -55,6 +59,8 @@ public:
     void configure(const configuration & cfg)
     {
         m_directory.configure(cfg.get_string("DBC.Directory"));
+        m_cache_directory.configure(cfg.get_string("DBC.Cache"));
+        m_locale = cfg.get_string("DBC.Locale");
     }
 
 
@@ -63,6 +69,18 @@ public:
         return m_directory.path();
     }
 
+    /* Where tables built from the dbc files are cached */
+    QString cache_path() const
+    {
+        return m_cache_directory.path();
+    }
+
+    /* The name of the locale of the dbc files, such as enUS or deDE */
+    QString locale() const
+    {
+        return m_locale;
+    }
+
     bool exists(const QString & file_name) const { return m_directory.exists(file_name); }
 
     bool add_file(const QString & file_name) const
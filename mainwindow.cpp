@@ -7,7 +7,10 @@
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::MainWindow)
+    ui(new Ui::MainWindow),
+    m_cfg("config"),
+    m_dbc_files(m_cfg),
+    m_resources()
 {
     ui->setupUi(this);
 
@@ -26,14 +29,18 @@ MainWindow::MainWindow(QWidget *parent) :
      */
 
     // A first look at the DBC components of this resource management system
-    configuration cfg("config");
-    m_creature_family = new creature_family_cb(cfg);
-    m_creature_type = new creature_type_cb(cfg);
+    m_creature_family.reset(new creature_family_cb(m_dbc_files,m_resources));
+    m_creature_type.reset(new creature_type_cb(m_dbc_files,m_resources));
     ui->centralWidget->layout()->addWidget(m_creature_family->get());
     ui->centralWidget->layout()->addWidget(m_creature_type->get());
+
+    // All resources are declared, start loading them
+    m_resources.start();
 }
 
 MainWindow::~MainWindow()
 {
+    // The widgets and files are destroyed after this, wait for the nodes building them first
+    m_resources.stop();
     delete ui;
 }
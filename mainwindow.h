@@ -2,7 +2,11 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <memory>
 #include "widgets/simple_dbc_combobox.h"
+#include "resource/resource_graph.h"
+#include "dbc/dbc_file_registry.h"
+#include "config.h"
 
 namespace Ui {
 class MainWindow;
@@ -19,10 +23,17 @@ public:
 private:
     Ui::MainWindow *ui;
 
+    configuration       m_cfg;
+    dbc_file_registry   m_dbc_files;
+    /* Stopped in ~MainWindow, before any of the resources its threads work on is destroyed. The files of the
+     * registry are declared before it and the widgets after it, so both outlive the nodes the graph holds of them. */
+    resource_graph      m_resources;
+
     typedef simple_dbc_combobox<creature_family_dbc,creature_family_projection> creature_family_cb;
     typedef simple_dbc_combobox<creature_type_dbc,creature_type_projection>     creature_type_cb;
-    creature_family_cb* m_creature_family;
-    creature_type_cb* m_creature_type;
+    /* Destroyed before the graph, which is stopped by then */
+    std::unique_ptr<creature_family_cb> m_creature_family;
+    std::unique_ptr<creature_type_cb>   m_creature_type;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,317 @@
+#ifndef RESOURCE_GRAPH_H
+#define RESOURCE_GRAPH_H
+
+#include <vector>
+#include <queue>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <algorithm>
+#include <initializer_list>
+#include "task_pool.h"
+
+/*
+ *  The resource directed acyclic graph
+ *
+ *  Every resource (a dbc_file, a dbc_table, a database table...) is a node in the graph. An edge A -> B says that
+ *  B is derived from A, so B can not be initialized before A is. Nodes are put in one of two lanes:
+ *
+ *      IO:  Nodes that access the disk (or the database). We assume that only one disk access can be served at a
+ *           time, so all of these are run one after another on a single thread.
+ *      CPU: Nodes that are derived from other resources in memory. These are run concurrently on a work-stealing
+ *           task_pool, as soon as all their inputs exist. The nodes can split their own work into tasks on the
+ *           same pool, see cpu_pool().
+ *
+ *  So while the I/O thread is busy loading the next file, derived resources of already loaded files are built.
+ *  Ready nodes with a higher priority are started first, which is useful for derived resources that take long.
+ *
+ *  All nodes and edges must be added before start() is called.
+ */
+
+enum class resource_lane
+{
+    IO,
+    CPU
+};
+
+enum class resource_node_state
+{
+    WAITING,    /* Some input is not yet initialized */
+    READY,      /* All inputs are initialized, waiting for a thread in its lane */
+    RUNNING,
+    COMPLETED
+};
+
+class resource_graph
+{
+public:
+    typedef unsigned int node_id;
+
+private:
+    struct node
+    {
+        resource_lane                       lane;
+        int                                 priority;
+        std::function<void()>               task;
+        /* Called once all dependents of this node are completed, to discard data no one needs anymore */
+        std::function<void()>               release;
+        std::vector<node_id>                dependents;
+        std::vector<node_id>                sources;
+        unsigned int                        inputs_remaining;
+        unsigned int                        dependents_remaining;
+        std::atomic<resource_node_state>    state;
+
+        node(resource_lane l, int p, std::function<void()> t) :
+            lane(l), priority(p), task(std::move(t)), release(), dependents(), sources(),
+            inputs_remaining(0), dependents_remaining(0), state(resource_node_state::WAITING)
+        {}
+    };
+
+    struct ready_order
+    {
+        const std::vector<std::unique_ptr<node>> * nodes;
+        bool operator () (node_id l, node_id r) const
+        {
+            /* Highest priority first, then in the order the nodes were declared */
+            const int pl = (*nodes)[l]->priority;
+            const int pr = (*nodes)[r]->priority;
+            return pl == pr ? l > r : pl < pr;
+        }
+    };
+    typedef std::priority_queue<node_id,std::vector<node_id>,ready_order> ready_queue;
+
+    std::vector<std::unique_ptr<node>>  m_nodes;
+    ready_queue                         m_ready_io;
+    ready_queue                         m_ready_cpu;
+    unsigned int                        m_completed;
+    bool                                m_started;
+    bool                                m_stop;
+
+    mutable std::mutex                  m_mutex;
+    std::condition_variable             m_work_available;
+    std::condition_variable             m_all_completed;
+
+    std::thread                         m_io_thread;
+    std::unique_ptr<task_pool>          m_cpu_pool;
+
+    ready_queue & queue_of(resource_lane lane)
+    {
+        return lane == resource_lane::IO ? m_ready_io : m_ready_cpu;
+    }
+
+    /* Must be called with m_mutex held */
+    void make_ready(node_id id)
+    {
+        m_nodes[id]->state = resource_node_state::READY;
+        queue_of(m_nodes[id]->lane).push(id);
+        /* Each ready CPU node gets a task on the pool, which runs whatever CPU node has the highest priority then */
+        if(m_nodes[id]->lane == resource_lane::CPU)
+            m_cpu_pool->submit([this](){ run_next_cpu_node(); });
+    }
+
+    void complete(node_id id)
+    {
+        std::vector<node_id> released;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            node & n = *m_nodes[id];
+            n.state = resource_node_state::COMPLETED;
+            ++m_completed;
+            for(node_id d : n.dependents)
+            {
+                if(--m_nodes[d]->inputs_remaining == 0)
+                    make_ready(d);
+            }
+            for(node_id s : n.sources)
+            {
+                if(--m_nodes[s]->dependents_remaining == 0 && m_nodes[s]->release)
+                    released.push_back(s);
+            }
+        }
+        for(node_id r : released)
+            m_nodes[r]->release();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_work_available.notify_all();
+        if(m_completed == m_nodes.size())
+            m_all_completed.notify_all();
+    }
+
+    void run_node(node_id id)
+    {
+        if(m_nodes[id]->task)
+            m_nodes[id]->task();
+        complete(id);
+    }
+
+    void run_io_lane()
+    {
+        for(;;)
+        {
+            node_id id;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_work_available.wait(lock,[this](){ return m_stop || !m_ready_io.empty() || m_completed == m_nodes.size(); });
+                if(m_stop || m_ready_io.empty())
+                    return;
+                id = m_ready_io.top();
+                m_ready_io.pop();
+                m_nodes[id]->state = resource_node_state::RUNNING;
+            }
+            run_node(id);
+        }
+    }
+
+    void run_next_cpu_node()
+    {
+        node_id id;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(m_stop || m_ready_cpu.empty())
+                return;
+            id = m_ready_cpu.top();
+            m_ready_cpu.pop();
+            m_nodes[id]->state = resource_node_state::RUNNING;
+        }
+        run_node(id);
+    }
+
+public:
+    resource_graph() :
+        m_nodes(),
+        m_ready_io(ready_order{&m_nodes}),
+        m_ready_cpu(ready_order{&m_nodes}),
+        m_completed(0),
+        m_started(false),
+        m_stop(false)
+    {
+    }
+    ~resource_graph()
+    {
+        stop();
+    }
+
+    resource_graph(const resource_graph&) = delete;
+    resource_graph& operator=(const resource_graph&) = delete;
+
+    /* Add a node running task in the given lane */
+    node_id add_node(resource_lane lane, std::function<void()> task, int priority = 0)
+    {
+        m_nodes.emplace_back(new node{lane,priority,std::move(task)});
+        return static_cast<node_id>(m_nodes.size()-1);
+    }
+
+    /* 'to' is derived from 'from' */
+    void add_edge(node_id from, node_id to)
+    {
+        m_nodes[from]->dependents.push_back(to);
+        ++m_nodes[from]->dependents_remaining;
+        m_nodes[to]->sources.push_back(from);
+        ++m_nodes[to]->inputs_remaining;
+    }
+
+    /* Call release once every node derived from id is completed */
+    void set_release(node_id id, std::function<void()> release)
+    {
+        m_nodes[id]->release = std::move(release);
+    }
+
+    /* A resource that is loaded from disk, such as a dbc_file. It is discarded once everything derived from it is built. */
+    template <typename R>
+    node_id add_file(R & resource, int priority = 0)
+    {
+        node_id id = add_node(resource_lane::IO,[&resource](){ resource.load(); },priority);
+        set_release(id,[&resource](){ resource.discard(); });
+        return id;
+    }
+
+    /* A resource that is built from the view of another resource, such as a dbc_table on a dbc_file.
+     * The resource may split its load into tasks on the pool it is given. Its cache is read before the load and written
+     * after it on the IO lane (see dbc_table::read_cache). The node of the load is returned, it is completed once the
+     * resource can be used. */
+    template <typename R, typename V>
+    node_id add_derived(R & resource, const V & source_view, node_id source, int priority = 0)
+    {
+        node_id read = add_node(resource_lane::IO,[&resource,&source_view]()
+        {
+            resource.configure(source_view);
+            resource.read_cache();
+        },priority);
+        add_edge(source,read);
+        node_id id = add_node(resource_lane::CPU,[this,&resource](){ resource.load(*m_cpu_pool); },priority);
+        /* The source is needed by the load, it is not released once the cache is read */
+        add_edge(source,id);
+        add_edge(read,id);
+        /* No one waits for the cache to be written, files still to be loaded go first */
+        node_id write = add_node(resource_lane::IO,[&resource](){ resource.write_cache(); },priority - 1);
+        add_edge(id,write);
+        return id;
+    }
+
+    /* A resource that is built from several resources in memory, such as a dbc_join of two dbc_tables. It is loaded
+     * once all of sources are, and may split its load into tasks on the pool it is given. */
+    template <typename R>
+    node_id add_combined(R & resource, std::initializer_list<node_id> sources, int priority = 0)
+    {
+        node_id id = add_node(resource_lane::CPU,[this,&resource](){ resource.load(*m_cpu_pool); },priority);
+        for(node_id source : sources)
+            add_edge(source,id);
+        return id;
+    }
+
+    /* Start initializing all resources, with one thread for disk access and cpu_threads workers for derived resources */
+    void start(unsigned int cpu_threads = std::max(1u,std::thread::hardware_concurrency()))
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_started)
+            return;
+        m_started = true;
+        m_cpu_pool.reset(new task_pool{cpu_threads});
+        for(node_id id = 0; id < m_nodes.size(); ++id)
+        {
+            if(m_nodes[id]->sources.empty())
+                make_ready(id);
+        }
+        m_io_thread = std::thread{[this](){ run_io_lane(); }};
+    }
+
+    /* Stop starting nodes, and block until the running ones are done. Nodes that did not start are never run, so
+     * the resources can be destroyed afterwards even if they are not initialized. */
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_work_available.notify_all();
+        if(m_io_thread.joinable())
+            m_io_thread.join();
+        /* The pool is kept until the graph is destroyed, the nodes finishing meanwhile still reach it */
+        if(m_cpu_pool)
+            m_cpu_pool->stop();
+    }
+
+    /* The pool running the CPU lane, available once started */
+    task_pool & cpu_pool() { return *m_cpu_pool; }
+
+    /* Block until every resource is initialized */
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_all_completed.wait(lock,[this](){ return m_completed == m_nodes.size(); });
+    }
+
+    resource_node_state state(node_id id) const { return m_nodes[id]->state; }
+    bool is_completed(node_id id) const { return state(id) == resource_node_state::COMPLETED; }
+    bool is_completed() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_completed == m_nodes.size();
+    }
+    unsigned int size() const { return static_cast<unsigned int>(m_nodes.size()); }
+};
+
+#endif // RESOURCE_GRAPH_H
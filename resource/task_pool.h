@@ -0,0 +1,318 @@
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <algorithm>
+#include <iterator>
+
+/*
+ *  A work-stealing pool of worker threads
+ *
+ *  Every worker has its own deque of tasks. A worker pushes and pops tasks at the back of its own deque, and when it
+ *  runs out of work it steals from the front of the other workers' deques. The oldest tasks are the biggest ones
+ *  when work is split recursively (see parallel_for), so a thief takes over as much work as possible at once.
+ *
+ *  Tasks can be counted in a task_group. A worker waiting for a group runs the pending tasks of that group meanwhile,
+ *  so it is fine for a task to split its work into new tasks and wait for them. Other threads (the GUI thread) sleep
+ *  until the group is done, they never run tasks of the pool.
+ */
+
+class task_group
+{
+private:
+    friend class task_pool;
+    std::atomic<unsigned int>   m_pending;
+    /* Guards the changes waiters look for: the last task done, or a new task submitted */
+    std::mutex                  m_mutex;
+    std::condition_variable     m_changed;
+    unsigned int                m_submitted;
+
+    void add()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_pending;
+    }
+    void submitted()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_submitted;
+        m_changed.notify_all();
+    }
+    /* The group may be destroyed by a waiter once this returns */
+    void done()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(--m_pending == 0)
+            m_changed.notify_all();
+    }
+public:
+    task_group() : m_pending(0), m_mutex(), m_changed(), m_submitted(0) {}
+    bool is_done() const { return m_pending == 0; }
+};
+
+class task_pool
+{
+private:
+    struct task
+    {
+        std::function<void()>   f;
+        task_group *            group;
+    };
+
+    struct worker_queue
+    {
+        std::mutex              mutex;
+        std::deque<task>        tasks;
+    };
+
+    std::vector<std::unique_ptr<worker_queue>>  m_queues;
+    std::vector<std::thread>                    m_threads;
+    std::atomic<unsigned int>                   m_queued;
+    std::atomic<unsigned int>                   m_next_queue;
+    bool                                        m_stop;
+    std::mutex                                  m_sleep_mutex;
+    std::condition_variable                     m_sleep;
+
+    /* The index of the queue owned by the calling thread, or -1 if it is not a worker of this pool */
+    int own_queue() const
+    {
+        return current_pool() == this ? current_index() : -1;
+    }
+    static const task_pool *& current_pool()
+    {
+        static thread_local const task_pool * pool = nullptr;
+        return pool;
+    }
+    static int & current_index()
+    {
+        static thread_local int index = -1;
+        return index;
+    }
+
+    bool pop(unsigned int q, task & t)
+    {
+        worker_queue & wq = *m_queues[q];
+        std::lock_guard<std::mutex> lock(wq.mutex);
+        if(wq.tasks.empty())
+            return false;
+        t = std::move(wq.tasks.back());
+        wq.tasks.pop_back();
+        --m_queued;
+        return true;
+    }
+
+    bool steal(unsigned int q, task & t)
+    {
+        worker_queue & wq = *m_queues[q];
+        std::lock_guard<std::mutex> lock(wq.mutex);
+        if(wq.tasks.empty())
+            return false;
+        t = std::move(wq.tasks.front());
+        wq.tasks.pop_front();
+        --m_queued;
+        return true;
+    }
+
+    /* Take a task of group from any queue, our own first */
+    bool take_of(const task_group & group, task & t)
+    {
+        const int own = own_queue();
+        const unsigned int n = static_cast<unsigned int>(m_queues.size());
+        const unsigned int start = own >= 0 ? static_cast<unsigned int>(own) : 0;
+        for(unsigned int i = 0; i < n; ++i)
+        {
+            worker_queue & wq = *m_queues[(start + i) % n];
+            std::lock_guard<std::mutex> lock(wq.mutex);
+            /* Like pop() and steal(): the newest of our own tasks, the oldest of the others */
+            if(i == 0 && own >= 0)
+            {
+                for(auto it = wq.tasks.rbegin(); it != wq.tasks.rend(); ++it)
+                {
+                    if(it->group != &group)
+                        continue;
+                    t = std::move(*it);
+                    wq.tasks.erase(std::next(it).base());
+                    --m_queued;
+                    return true;
+                }
+                continue;
+            }
+            for(auto it = wq.tasks.begin(); it != wq.tasks.end(); ++it)
+            {
+                if(it->group != &group)
+                    continue;
+                t = std::move(*it);
+                wq.tasks.erase(it);
+                --m_queued;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /* Take a task from our own queue, or steal one from another worker */
+    bool take(task & t)
+    {
+        const int own = own_queue();
+        if(own >= 0 && pop(static_cast<unsigned int>(own),t))
+            return true;
+        const unsigned int n = static_cast<unsigned int>(m_queues.size());
+        const unsigned int start = own >= 0 ? static_cast<unsigned int>(own) + 1 : 0;
+        for(unsigned int i = 0; i < n; ++i)
+        {
+            const unsigned int q = (start + i) % n;
+            if(static_cast<int>(q) != own && steal(q,t))
+                return true;
+        }
+        return false;
+    }
+
+    void run(task & t)
+    {
+        t.f();
+        if(t.group)
+            t.group->done();
+    }
+
+    void work(unsigned int index)
+    {
+        current_pool() = this;
+        current_index() = static_cast<int>(index);
+        for(;;)
+        {
+            task t;
+            if(take(t))
+            {
+                run(t);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_sleep_mutex);
+            m_sleep.wait(lock,[this](){ return m_stop || m_queued > 0; });
+            if(m_stop)
+                return;
+        }
+    }
+
+public:
+    task_pool(unsigned int threads = std::max(1u,std::thread::hardware_concurrency())) :
+        m_queued(0),
+        m_next_queue(0),
+        m_stop(false)
+    {
+        threads = std::max(1u,threads);
+        for(unsigned int i = 0; i < threads; ++i)
+            m_queues.emplace_back(new worker_queue);
+        for(unsigned int i = 0; i < threads; ++i)
+            m_threads.emplace_back([this,i](){ work(i); });
+    }
+    ~task_pool()
+    {
+        stop();
+    }
+
+    task_pool(const task_pool&) = delete;
+    task_pool& operator=(const task_pool&) = delete;
+
+    unsigned int size() const { return static_cast<unsigned int>(m_threads.size()); }
+
+    /* Run the queued tasks, and join the workers once there are none left. Tasks must not be submitted afterwards. */
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleep_mutex);
+            m_stop = true;
+        }
+        m_sleep.notify_all();
+        for(std::thread & t : m_threads)
+        {
+            if(t.joinable())
+                t.join();
+        }
+    }
+
+    /* Queue f, counted in group if given. Workers queue on their own deque, other threads spread tasks over all deques. */
+    void submit(std::function<void()> f, task_group * group = nullptr)
+    {
+        if(group)
+            group->add();
+        const int own = own_queue();
+        const unsigned int q = own >= 0 ? static_cast<unsigned int>(own) : m_next_queue++ % m_queues.size();
+        {
+            std::lock_guard<std::mutex> lock(m_sleep_mutex);
+            ++m_queued;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_queues[q]->mutex);
+            m_queues[q]->tasks.push_back(task{std::move(f),group});
+        }
+        m_sleep.notify_one();
+        /* A worker waiting for the group may run it */
+        if(group)
+            group->submitted();
+    }
+
+    /* Block until every task in group is done. A worker of the pool runs pending tasks of group meanwhile, other
+     * threads sleep. */
+    void wait(task_group & group)
+    {
+        const bool worker = own_queue() >= 0;
+        for(;;)
+        {
+            /* Counted before looking for tasks, so a task submitted meanwhile wakes us up */
+            unsigned int submitted;
+            {
+                std::lock_guard<std::mutex> lock(group.m_mutex);
+                if(group.m_pending == 0)
+                    return;
+                submitted = group.m_submitted;
+            }
+            task t;
+            if(worker && take_of(group,t))
+            {
+                run(t);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(group.m_mutex);
+            group.m_changed.wait(lock,[&group,worker,submitted]()
+            {
+                return group.m_pending == 0 || (worker && group.m_submitted != submitted);
+            });
+            /* Seen under the lock of the group, so the last task is done with it */
+            if(group.m_pending == 0)
+                return;
+        }
+    }
+
+    /* Call f(begin,end) on ranges of at most grain indices covering [begin,end), and wait for all of them.
+     * The range is split in halves, so that idle workers steal large parts of it. */
+    template <typename F>
+    void parallel_for(unsigned int begin, unsigned int end, unsigned int grain, const F & f)
+    {
+        task_group group;
+        split(begin,end,std::max(1u,grain),f,group);
+        wait(group);
+    }
+
+private:
+    template <typename F>
+    void split(unsigned int begin, unsigned int end, unsigned int grain, const F & f, task_group & group)
+    {
+        while(end - begin > grain)
+        {
+            const unsigned int mid = begin + (end - begin)/2;
+            submit([this,mid,end,grain,&f,&group](){ split(mid,end,grain,f,group); },&group);
+            end = mid;
+        }
+        if(begin < end)
+            f(begin,end);
+    }
+};
+
+#endif // TASK_POOL_H
@@ -1,6 +1,8 @@
 #ifndef DBC_ITEM_MODEL_H
 #define DBC_ITEM_MODEL_H
 
+#include <vector>
+#include <unordered_map>
 #include "dbc/dbc_table.h"
 #include <QStandardItemModel>
 
@@ -94,12 +96,69 @@ public:
 
 private:
     const model_adaptor_base & m_view;
+    /* The rows the attached views know of */
+    int m_rows;
 public:
     dbc_item_model(const model_adaptor_base & view) :
-        m_view(view)
+        m_view(view),
+        m_rows(view.rows())
     {
     }
 
+    /* Tell the attached views about the rows the view got since, such as the batches a streamed table publishes while
+     * it loads (see dbc_table::set_streaming). Views of fewer rows are reset. */
+    void update_rows()
+    {
+        const int rows = m_view.rows();
+        if(rows > m_rows)
+        {
+            beginInsertRows(QModelIndex{},m_rows,rows-1);
+            m_rows = rows;
+            endInsertRows();
+        }
+        else if(rows < m_rows)
+        {
+            beginResetModel();
+            m_rows = rows;
+            endResetModel();
+        }
+    }
+
+    /* Let reorder() change the order of the rows of the view, such as a dbc_table view taking over a sorted order, and
+     * keep the persistent indexes (the current item of a combo box, the selection of a table view) on their records.
+     * row_of(index) identifies the record at an index of the view, such as its row in the table. reorder() must keep
+     * the same records. */
+    template <typename ROW_OF, typename REORDER>
+    void reorder(ROW_OF row_of, REORDER reorder)
+    {
+        emit layoutAboutToBeChanged();
+        const QModelIndexList from = persistentIndexList();
+        std::unordered_map<unsigned int,int> index_of_row;
+        std::vector<unsigned int> rows;
+        rows.reserve(static_cast<size_t>(from.size()));
+        for(const QModelIndex & i : from)
+        {
+            rows.push_back(row_of(i.row()));
+            index_of_row.emplace(rows.back(),-1);
+        }
+        reorder();
+        /* Only the records of persistent indexes are looked for */
+        for(int i = 0; i < m_rows && !index_of_row.empty(); ++i)
+        {
+            auto it = index_of_row.find(row_of(i));
+            if(it != index_of_row.end())
+                it->second = i;
+        }
+        QModelIndexList to;
+        for(int i = 0; i < from.size(); ++i)
+        {
+            const int row = index_of_row[rows[static_cast<size_t>(i)]];
+            to.append(row < 0 ? QModelIndex{} : index(row,from[i].column()));
+        }
+        changePersistentIndexList(from,to);
+        emit layoutChanged();
+    }
+
     int columnCount(const QModelIndex &parent = QModelIndex()) const
     {
         if(parent.isValid())
@@ -119,7 +178,7 @@ public:
         }
         else
         {
-            return m_view.rows();
+            return m_rows;
         }
     }
 
@@ -2,9 +2,12 @@
 #define SIMPLE_DBC_COMBOBOX_H
 
 #include <QComboBox>
+#include <QTimer>
 #include "../directory.h"
 #include "../dbc/dbc.h"
 #include "../dbc/dbc_files.h"
+#include "../dbc/dbc_file_registry.h"
+#include "../resource/resource_graph.h"
 #include "dbc/dbc_table.h"
 #include "dbc_item_model.h"
 #include <QTableView>
@@ -16,45 +19,105 @@ template <typename dbc_file_description, typename dbc_table_projection>
 class simple_dbc_combobox
 {
     QComboBox b;
+    QTimer    m_progress_timer;
 
-    typedef dbc_file<dbc_file_description>                           file_type;
-    typedef dbc_table<typename file_type::view,dbc_table_projection> table_type;
+    typedef dbc_shared_file<dbc_file_description>                    shared_file;
+    typedef typename shared_file::view_type                          file_view;
+    typedef dbc_table<file_view,dbc_table_projection>                table_type;
     typedef typename table_type::view                                table_view;
-    file_type                       m_dbc_file;
+    const resource_graph &          m_resources;
+    shared_file                     m_dbc_file;
     table_type                      m_dbc_table;
     table_view                      m_dbc_table_view;
     dbc_model_adaptor<table_view>   m_table_adaptor;
+    resource_graph::node_id         m_table_node;
+    dbc_item_model *                m_item_model;
+    bool                            m_sort_requested;
+
+    void on_progress()
+    {
+        if(m_item_model)
+        {
+            // Step 5: Show the entries the table publishes while it is streamed
+            m_item_model->update_rows();
+            if(m_dbc_table.is_streaming())
+                return;
+            // The entries are listed by name once the table is loaded, other views of the table can have other
+            //          orders. The sort runs in the background, until it is done the entries are listed by ID.
+            //          The entries of a streamed table, listed in the order of the file so far, are listed by ID
+            //          when the sort is requested. The current entry stays selected when the order changes.
+            auto row_of = [this](int idx){ return m_dbc_table_view.row_at(static_cast<unsigned int>(idx)); };
+            if(!m_sort_requested)
+            {
+                m_item_model->reorder(row_of,[this](){ m_dbc_table_view.sort_by(1); });
+                m_sort_requested = true;
+            }
+            // Step 6: Show the entries in their new order once they are sorted
+            if(m_dbc_table_view.has_new_order())
+                m_item_model->reorder(row_of,[this](){ m_dbc_table_view.update_order(); });
+            if(!m_dbc_table_view.is_sorting())
+                m_progress_timer.stop();
+            return;
+        }
+        // The entries are shown as soon as the table publishes the first of them
+        const bool streaming = m_dbc_table.is_streaming();
+        if(!streaming && !m_resources.is_completed(m_table_node))
+        {
+            if(m_dbc_file.file().is_loading())
+                b.setToolTip(QString{"Loading %1..."}.arg(m_dbc_file.view().progress_value(),0,'f',0) + QString{"%"});
+            return;
+        }
+        if(!streaming)
+        {
+            qDebug(m_dbc_table.error_msg().c_str());
+            if(!m_dbc_table.is_completed())
+            {
+                m_progress_timer.stop();
+                b.setToolTip(QString{m_dbc_table.error_msg().c_str()});
+                return;
+            }
+        }
+
+        // Step 3: Setup the Qt item model, depending on the table
+        m_item_model = new dbc_item_model(m_table_adaptor);
+
+        // Step 4: Assign model to view
+        b.setModel(m_item_model);
+        b.setModelColumn(1);
+        b.setToolTip(QString{});
+        b.setEnabled(true);
+    }
+
 public:
-    simple_dbc_combobox(const configuration & cfg) :
+    simple_dbc_combobox(dbc_file_registry & files, resource_graph & resources) :
         b(),
-        m_dbc_file(),
+        m_progress_timer(),
+        m_resources(resources),
+        // Step 1: Get the file, it is shared with every other resource built from it and loaded once on the I/O thread
+        //          of the resource graph
+        m_dbc_file(files.acquire<dbc_file_description>(resources)),
         m_dbc_table(),
         m_dbc_table_view(m_dbc_table()),
-        m_table_adaptor(m_dbc_table_view)
+        m_table_adaptor(m_dbc_table_view),
+        m_table_node(0),
+        m_item_model(nullptr),
+        m_sort_requested(false)
     {
-        dbc_directory dir(cfg);
-
-        // Step 1: Load the file
-        m_dbc_file.configure(dir);
-        m_dbc_file.load();
-        qDebug(m_dbc_file.error_msg().c_str());
-
-        // Step 2: Load the table that is dependent on the file
-        auto file_view = m_dbc_file();
-        m_dbc_table.configure(file_view);
-        m_dbc_table.load();
-        qDebug(m_dbc_table.error_msg().c_str());
+        // Step 2: Declare the table that is dependent on the file. It is built as soon as the file is loaded (or read
+        //          from the cache if the file did not change), and the file data is discarded by the graph once the
+        //          last table depending on it is built.
+        m_dbc_table.set_cache_directory(files.directory().cache_path());
+        m_dbc_table.set_locale(dbc_locale_from_name(files.directory().locale()));
+        // The entries are published in batches while the table is built, so the first of them show at once. A
+        //          streamed table keeps the strings of every locale though, so tables of localized strings (such as
+        //          CreatureFamily, which is small anyway) are not streamed and keep only the strings of the locale.
+        m_dbc_table.set_streaming(!dbc_table_types<file_view,dbc_table_projection>::has_localized_string);
+        m_table_node = resources.add_derived(m_dbc_table, m_dbc_file.view(), m_dbc_file.node());
 
-        // Step 3: We can now discard file data since all dependencies are initialized. And no other resource
-        //          directly depends on file data anymore.
-        m_dbc_file.discard();
-
-        // Step 4: Setup the Qt item model, depending on the table
-        dbc_item_model * item_model = new dbc_item_model(m_table_adaptor);
-
-        // Step 5: Assign model to view
-        b.setModel(item_model);
-        b.setModelColumn(1);
+        // The widget is shown disabled until the table is built
+        b.setEnabled(false);
+        QObject::connect(&m_progress_timer, &QTimer::timeout, [this](){ on_progress(); });
+        m_progress_timer.start(15);
     }
     ~simple_dbc_combobox(){}
 
@@ -30,7 +30,8 @@ SOURCES += main.cpp\
     database/creature_template.cpp \
     database/page_text.cpp \
     database/test.cpp \
-    dbc/dbc_files.cpp
+    dbc/dbc_files.cpp \
+    dbc/dbc_scan.cpp
 
 HEADERS  += mainwindow.h \
     database/circularqueue.h \
@@ -38,13 +39,29 @@ HEADERS  += mainwindow.h \
     database/dbinterface.h \
     database/dbtmp.h \
     database/page_text.h \
+    database/reference_index.h \
     database/table.h \
     database/test.h \
     dbc/dbc.h \
+    dbc/dbc_aggregate.h \
+    dbc/dbc_bitmap_index.h \
+    dbc/dbc_cache.h \
+    dbc/dbc_collation.h \
+    dbc/dbc_columns.h \
+    dbc/dbc_file_registry.h \
     dbc/dbc_files.h \
+    dbc/dbc_filter.h \
+    dbc/dbc_hash.h \
+    dbc/dbc_join.h \
     dbc/dbc_projection.h \
     dbc/dbc_record.h \
+    dbc/dbc_scan.h \
+    dbc/dbc_search.h \
+    dbc/dbc_sort.h \
+    dbc/dbc_strings.h \
     dbc/dbc_table.h \
+    resource/resource_graph.h \
+    resource/task_pool.h \
     tmp/tmp.h \
     tmp/tmp_function.h \
     tmp/tmp_math.h \